@@ -0,0 +1,225 @@
+#include "DSResult/DSResult.hpp"
+#include "DSResult/AsyncErrorSink.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+//Request threads log their errors either by formatting and writing them on the spot, or by pushing
+//them to a `DS::AsyncErrorSink`. Both write the same `ToString()` text to a temporary file and
+//flush it, only the thread doing it differs.
+namespace
+{
+    std::FILE* LogFile = nullptr;
+
+    struct ThreadResult
+    {
+        std::vector<std::int64_t> ErrorLatencies;
+        std::vector<std::int64_t> SuccessLatencies;
+    };
+
+    //xorshift32, each thread has its own state so the error decisions are reproducible
+    inline std::uint32_t NextRandom(std::uint32_t& state)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    void WriteText(const DS::ErrorTrace& trace)
+    {
+        std::string text = trace.ToString();
+        text += '\n';
+        std::fwrite(text.data(), 1, text.size(), LogFile);
+        std::fflush(LogFile);
+    }
+
+    void WriteToLog(void*, const DS::ErrorTrace& trace)
+    {
+        WriteText(trace);
+    }
+
+    DS::Result<int> Parse(int value, bool fail)
+    {
+        if(fail)
+            return DS_ERROR_MSG_EC("Upstream returned an invalid response for the request", 502);
+        return value;
+    }
+
+    DS::Result<int> Load(int depth, int value, bool fail)
+    {
+        if(depth == 0)
+            return Parse(value, fail);
+        int loaded = Load(depth - 1, value, fail).DS_TRY();
+        return loaded + 1;
+    }
+
+    int HandleSynchronous(int value, bool fail)
+    {
+        int loaded = Load(8, value, fail).DS_TRY_ACT(WriteText(DS_TMP_ERROR); return -1);
+        return loaded;
+    }
+
+    int HandleAsynchronous(DS::AsyncErrorSink& sink, int value, bool fail)
+    {
+        int loaded = Load(8, value, fail).DS_TRY_ACT(DS_PUSH_ERROR(sink, DS_TMP_ERROR); return -1);
+        return loaded;
+    }
+
+    std::int64_t Percentile(const std::vector<std::int64_t>& sorted, double percentile)
+    {
+        if(sorted.empty())
+            return 0;
+        std::size_t index = (std::size_t)(percentile / 100.0 * (double)(sorted.size() - 1) + 0.5);
+        return sorted[index];
+    }
+
+    void PrintLatencies(const char* name, std::vector<std::int64_t>& latencies)
+    {
+        std::sort(latencies.begin(), latencies.end());
+        std::printf("  %-14s %10zu ops  p50 %8lld ns  p99 %8lld ns  p999 %8lld ns\n",
+                    name,
+                    latencies.size(),
+                    (long long)Percentile(latencies, 50.0),
+                    (long long)Percentile(latencies, 99.0),
+                    (long long)Percentile(latencies, 99.9));
+    }
+
+    //`handle` is called with the value and whether it should fail
+    template<typename F>
+    void RunBenchmark(  const char* name,
+                        int threadCount,
+                        int iterations,
+                        std::uint64_t failThreshold,
+                        F&& handle)
+    {
+        std::vector<ThreadResult> results(threadCount);
+        std::atomic<int> readyCount(0);
+        std::atomic<bool> start(false);
+        std::vector<std::thread> threads;
+
+        for(int t = 0; t < threadCount; ++t)
+        {
+            threads.emplace_back([&, t]()
+            {
+                #if DS_USE_REALTIME_POOL
+                    DS::ReserveErrorPool(DS_REALTIME_DEFAULT_POOL_SIZE);
+                #endif
+
+                ThreadResult& result = results[t];
+                result.ErrorLatencies.reserve(iterations);
+                result.SuccessLatencies.reserve(iterations);
+                std::uint32_t random = 0x9E3779B9u ^ (std::uint32_t)(t + 1) * 2654435761u;
+
+                ++readyCount;
+                while(!start.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+
+                for(int i = 0; i < iterations; ++i)
+                {
+                    const bool fail = NextRandom(random) < failThreshold;
+                    auto begin = std::chrono::steady_clock::now();
+                    handle(i, fail);
+                    auto end = std::chrono::steady_clock::now();
+
+                    std::int64_t nanoseconds =
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+                    if(fail)
+                        result.ErrorLatencies.push_back(nanoseconds);
+                    else
+                        result.SuccessLatencies.push_back(nanoseconds);
+                }
+            });
+        }
+
+        while(readyCount.load() != threadCount)
+            std::this_thread::yield();
+
+        start.store(true, std::memory_order_release);
+        for(std::size_t t = 0; t < threads.size(); ++t)
+            threads[t].join();
+
+        std::vector<std::int64_t> errorLatencies;
+        std::vector<std::int64_t> successLatencies;
+        for(std::size_t t = 0; t < results.size(); ++t)
+        {
+            errorLatencies.insert(  errorLatencies.end(),
+                                    results[t].ErrorLatencies.begin(),
+                                    results[t].ErrorLatencies.end());
+            successLatencies.insert(successLatencies.end(),
+                                    results[t].SuccessLatencies.begin(),
+                                    results[t].SuccessLatencies.end());
+        }
+
+        std::printf("%s\n", name);
+        PrintLatencies("Error path", errorLatencies);
+        PrintLatencies("Success path", successLatencies);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int threadCount = argc > 1 ? std::atoi(argv[1]) : (int)std::thread::hardware_concurrency();
+    double errorRate = argc > 2 ? std::atof(argv[2]) : 10.0;
+    int iterations = argc > 3 ? std::atoi(argv[3]) : 100000;
+    int capacity = argc > 4 ? std::atoi(argv[4]) : 4096;
+
+    if(threadCount <= 0)
+        threadCount = 1;
+    if(errorRate < 0.0 || errorRate > 100.0 || iterations <= 0 || capacity <= 0)
+    {
+        std::printf("Usage: %s [threads] [error rate %%] [iterations per thread] [capacity]\n",
+                    argv[0]);
+        return 1;
+    }
+
+    LogFile = std::tmpfile();
+    if(LogFile == nullptr)
+    {
+        std::printf("Failed to create the log file\n");
+        return 1;
+    }
+
+    const std::uint64_t failThreshold = (std::uint64_t)(errorRate / 100.0 * 4294967296.0);
+    std::printf("Threads: %d, error rate: %.2f%%, iterations: %d, capacity: %d\n",
+                threadCount,
+                errorRate,
+                iterations,
+                capacity);
+
+    RunBenchmark("Synchronous", threadCount, iterations, failThreshold, [](int i, bool fail)
+    {
+        HandleSynchronous(i, fail);
+    });
+
+    for(int policy = 0; policy < 2; ++policy)
+    {
+        DS::SinkOverflowPolicy overflowPolicy = policy == 0 ?
+                                                DS::SinkOverflowPolicy::DropNewest :
+                                                DS::SinkOverflowPolicy::DropOldest;
+        DS::AsyncErrorSink sink((std::size_t)capacity, WriteToLog, nullptr, overflowPolicy);
+        RunBenchmark(   policy == 0 ? "Asynchronous (DropNewest)" : "Asynchronous (DropOldest)",
+                        threadCount,
+                        iterations,
+                        failThreshold,
+                        [&sink](int i, bool fail)
+                        {
+                            HandleAsynchronous(sink, i, fail);
+                        });
+        sink.Stop();
+        std::printf("  Pushed %llu, written %llu, dropped %llu\n",
+                    (unsigned long long)sink.GetPushedCount(),
+                    (unsigned long long)sink.GetWrittenCount(),
+                    (unsigned long long)sink.GetDroppedCount());
+    }
+
+    std::fclose(LogFile);
+    return 0;
+}
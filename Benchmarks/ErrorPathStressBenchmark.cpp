@@ -0,0 +1,204 @@
+#include "DSResult/DSResult.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+//Worker threads create and propagate errors at the same time to show allocator contention on the
+//error path. Build with and without `DS_USE_REALTIME_POOL` to compare the storage strategies.
+namespace
+{
+    #if DS_USE_REALTIME_POOL
+        const char* StorageName = "realtime pool";
+    #else
+        const char* StorageName = "default allocator";
+    #endif
+
+    //Longer than the small string buffer so the message is allocated
+    const char* FailureMessage = "Upstream returned an invalid response for the request";
+
+    struct ThreadResult
+    {
+        std::vector<std::int64_t> ErrorLatencies;
+        std::vector<std::int64_t> SuccessLatencies;
+        long long Checksum;
+    };
+
+    //xorshift32, each thread has its own state so the error decisions are reproducible
+    inline std::uint32_t NextRandom(std::uint32_t& state)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    DS::Result<int> Parse(int value, bool fail)
+    {
+        if(fail)
+            return DS_ERROR_MSG_EC(FailureMessage, 502);
+        return value;
+    }
+
+    DS::Result<int> Decode(int value, bool fail)
+    {
+        int parsed = Parse(value, fail).DS_TRY();
+        return parsed + 1;
+    }
+
+    DS::Result<int> Forward(int depth, int value, bool fail)
+    {
+        if(depth == 0)
+            return Decode(value, fail);
+        int decoded = Forward(depth - 1, value, fail).DS_TRY();
+        return decoded;
+    }
+
+    DS::Result<int> Load(int depth, int value, bool fail)
+    {
+        DS::Result<int> result = Forward(depth, value, fail);
+        DS_CHECK_CTX(result, DS_CTX_KV("requestId", value));
+        return result.value();
+    }
+
+    DS::Result<int> Handle(int depth, int value, bool fail)
+    {
+        DS_UNWRAP_DECL(int loaded, Load(depth, value, fail));
+        return loaded * 2;
+    }
+
+    std::int64_t Percentile(const std::vector<std::int64_t>& sorted, double percentile)
+    {
+        if(sorted.empty())
+            return 0;
+        std::size_t index = (std::size_t)(percentile / 100.0 * (double)(sorted.size() - 1) + 0.5);
+        return sorted[index];
+    }
+
+    void PrintLatencies(const char* name, std::vector<std::int64_t>& latencies)
+    {
+        std::sort(latencies.begin(), latencies.end());
+        std::printf("  %-14s %10zu ops  p50 %8lld ns  p99 %8lld ns  p999 %8lld ns\n",
+                    name,
+                    latencies.size(),
+                    (long long)Percentile(latencies, 50.0),
+                    (long long)Percentile(latencies, 99.0),
+                    (long long)Percentile(latencies, 99.9));
+    }
+
+    //Runs `iterations` requests on each of `threadCount` threads started together
+    void RunStress(int threadCount, std::uint64_t failThreshold, int iterations, int depth)
+    {
+        std::vector<ThreadResult> results(threadCount);
+        std::atomic<int> readyCount(0);
+        std::atomic<bool> start(false);
+        std::vector<std::thread> threads;
+
+        for(int t = 0; t < threadCount; ++t)
+        {
+            threads.emplace_back([&, t]()
+            {
+                #if DS_USE_REALTIME_POOL
+                    DS::ReserveErrorPool(DS_REALTIME_DEFAULT_POOL_SIZE);
+                #endif
+
+                ThreadResult& result = results[t];
+                result.ErrorLatencies.reserve(iterations);
+                result.SuccessLatencies.reserve(iterations);
+                result.Checksum = 0;
+                std::uint32_t random = 0x9E3779B9u ^ (std::uint32_t)(t + 1) * 2654435761u;
+
+                ++readyCount;
+                while(!start.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+
+                for(int i = 0; i < iterations; ++i)
+                {
+                    const bool fail = NextRandom(random) < failThreshold;
+                    auto begin = std::chrono::steady_clock::now();
+                    DS::Result<int> handled = Handle(depth, i, fail);
+                    result.Checksum += handled.has_value() ?
+                                       handled.value() :
+                                       (long long)handled.error().Stack.size();
+                    auto end = std::chrono::steady_clock::now();
+
+                    std::int64_t nanoseconds =
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+                    if(fail)
+                        result.ErrorLatencies.push_back(nanoseconds);
+                    else
+                        result.SuccessLatencies.push_back(nanoseconds);
+                }
+            });
+        }
+
+        while(readyCount.load() != threadCount)
+            std::this_thread::yield();
+
+        auto begin = std::chrono::steady_clock::now();
+        start.store(true, std::memory_order_release);
+        for(std::size_t t = 0; t < threads.size(); ++t)
+            threads[t].join();
+        auto end = std::chrono::steady_clock::now();
+
+        std::vector<std::int64_t> errorLatencies;
+        std::vector<std::int64_t> successLatencies;
+        long long checksum = 0;
+        for(std::size_t t = 0; t < results.size(); ++t)
+        {
+            errorLatencies.insert(  errorLatencies.end(),
+                                    results[t].ErrorLatencies.begin(),
+                                    results[t].ErrorLatencies.end());
+            successLatencies.insert(successLatencies.end(),
+                                    results[t].SuccessLatencies.begin(),
+                                    results[t].SuccessLatencies.end());
+            checksum += results[t].Checksum;
+        }
+
+        const double seconds = std::chrono::duration<double>(end - begin).count();
+        const double totalOps = (double)threadCount * iterations;
+        std::printf("Threads: %d\n", threadCount);
+        std::printf("  Throughput: %.2f Mops/s (%.2f Mops/s per thread), checksum %lld\n",
+                    totalOps / seconds / 1e6,
+                    totalOps / seconds / 1e6 / threadCount,
+                    checksum);
+        PrintLatencies("Error path", errorLatencies);
+        PrintLatencies("Success path", successLatencies);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int threadCount = argc > 1 ? std::atoi(argv[1]) : (int)std::thread::hardware_concurrency();
+    double errorRate = argc > 2 ? std::atof(argv[2]) : 10.0;
+    int iterations = argc > 3 ? std::atoi(argv[3]) : 100000;
+    int depth = argc > 4 ? std::atoi(argv[4]) : 8;
+
+    if(threadCount <= 0)
+        threadCount = 1;
+    if(errorRate < 0.0 || errorRate > 100.0 || iterations <= 0 || depth < 0)
+    {
+        std::printf("Usage: %s [max threads] [error rate %%] [iterations per thread] [depth]\n",
+                    argv[0]);
+        return 1;
+    }
+
+    const std::uint64_t failThreshold = (std::uint64_t)(errorRate / 100.0 * 4294967296.0);
+    std::printf("Storage: %s, max threads: %d, error rate: %.2f%%, depth: %d, iterations: %d\n",
+                StorageName,
+                threadCount,
+                errorRate,
+                depth,
+                iterations);
+
+    //Doubles the thread count up to the maximum so the contention shows as a curve
+    for(int count = 1; count < threadCount; count *= 2)
+        RunStress(count, failThreshold, iterations, depth);
+    RunStress(threadCount, failThreshold, iterations, depth);
+    return 0;
+}
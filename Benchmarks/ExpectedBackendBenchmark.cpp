@@ -0,0 +1,104 @@
+#include "DSResult/DSResult.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+//Built once for each expected backend to compare them on the same call chains
+namespace
+{
+    #if DS_USE_NATIVE_EXPECTED
+        const char* BackendName = "native";
+    #elif DS_USE_STD_EXPECTED
+        const char* BackendName = "std::expected";
+    #elif DS_USE_EXPECTED_LITE
+        const char* BackendName = "expected-lite";
+    #else
+        const char* BackendName = "tl::expected";
+    #endif
+
+    const int CallDepth = 8;
+
+    //Prevents the calls from being folded into constants
+    volatile int FailAt = -1;
+
+    DS::Result<int> Leaf(int value)
+    {
+        if(value == FailAt)
+            return DS_ERROR_MSG_EC("Leaf failed", 1);
+        return value;
+    }
+
+    DS::Result<int> Propagate(int depth, int value)
+    {
+        if(depth == 0)
+            return Leaf(value);
+        int result = Propagate(depth - 1, value).DS_TRY();
+        return result + 1;
+    }
+
+    DS::Result<void> PropagateVoid(int depth, int value)
+    {
+        if(depth == 0)
+        {
+            DS_UNWRAP_VOID(Leaf(value));
+            return {};
+        }
+        DS_UNWRAP_VOID(PropagateVoid(depth - 1, value));
+        return {};
+    }
+
+    //`func` returns a value that is accumulated so the calls aren't removed
+    template<typename F>
+    void RunBenchmark(const char* name, int iterations, F&& func)
+    {
+        long long sum = 0;
+        for(int i = 0; i < iterations / 10; ++i)
+            sum += func(i);
+
+        auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < iterations; ++i)
+            sum += func(i);
+        auto end = std::chrono::steady_clock::now();
+
+        double seconds = std::chrono::duration<double>(end - start).count();
+        std::printf("%-24s %10.1f ns/op (%lld)\n", name, seconds * 1e9 / iterations, sum);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 1000000;
+
+    std::printf("Backend: %s, sizeof(DS::Result<int>): %zu, sizeof(DS::Result<void>): %zu\n",
+                BackendName,
+                sizeof(DS::Result<int>),
+                sizeof(DS::Result<void>));
+
+    RunBenchmark("Success", iterations, [](int i)
+    {
+        DS::Result<int> result = Propagate(CallDepth, i);
+        return result.has_value() ? (long long)result.value() : 0LL;
+    });
+
+    RunBenchmark("Success (void)", iterations, [](int i)
+    {
+        return PropagateVoid(CallDepth, i).has_value() ? 1LL : 0LL;
+    });
+
+    RunBenchmark("Error", iterations / 10, [](int i)
+    {
+        FailAt = i;
+        DS::Result<int> result = Propagate(CallDepth, i);
+        return result.has_value() ? 0LL : (long long)result.error().Stack.size();
+    });
+
+    RunBenchmark("Error (void)", iterations / 10, [](int i)
+    {
+        FailAt = i;
+        DS::Result<void> result = PropagateVoid(CallDepth, i);
+        return result.has_value() ? 0LL : (long long)result.error().Stack.size();
+    });
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include "DSResult/DSResult.hpp"
+#include "DSResult/StructuredWriter.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace
+{
+    DS::ErrorTrace CreateTrace()
+    {
+        DS::ErrorTrace trace = DS::ErrorTrace(  "Failed to parse \"config.json\": unexpected token",
+                                                DS::TraceElement("ParseValue", "Parser.cpp", 120),
+                                                42);
+        for(int i = 0; i < 8; ++i)
+            trace.AppendTrace(DS::TraceElement("ParseObject", "Parser.cpp", 200 + i));
+        trace.AppendContext(DS_CTX_KV("requestId", 123456));
+        trace.AppendTrace(DS::TraceElement("LoadConfig", "Config.cpp", 33));
+        trace.AppendContext(DS_CTX_CAPTURE("file", "config.json"));
+        return trace;
+    }
+    
+    //`func` returns the number of bytes produced
+    template<typename F>
+    void RunBenchmark(const char* name, int iterations, F&& func)
+    {
+        std::size_t bytes = 0;
+        for(int i = 0; i < iterations / 10; ++i)
+            bytes += func();
+        
+        bytes = 0;
+        auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < iterations; ++i)
+            bytes += func();
+        auto end = std::chrono::steady_clock::now();
+        
+        double seconds = std::chrono::duration<double>(end - start).count();
+        std::printf("%-24s %10.1f ns/op %10.1f MB/s\n", 
+                    name, 
+                    seconds * 1e9 / iterations,
+                    (double)bytes / seconds / 1e6);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 200000;
+    DS::ErrorTrace trace = CreateTrace();
+    std::FILE* nullFile = std::fopen("/dev/null", "w");
+    if(nullFile == nullptr)
+    {
+        std::printf("Failed to open /dev/null\n");
+        return 1;
+    }
+    
+    char buffer[4096];
+    std::size_t jsonSize = DS::WriteStructured(trace, DS::StructuredFormat::Json, buffer, 0) + 1;
+    std::size_t logfmtSize = DS::WriteStructured(trace, DS::StructuredFormat::Logfmt, buffer, 0) + 1;
+    
+    RunBenchmark("ToString()", iterations, [&]()
+    {
+        std::string str = trace.ToString();
+        return str.size();
+    });
+    
+    RunBenchmark("ToString() + fwrite", iterations, [&]()
+    {
+        std::string str = trace.ToString();
+        return std::fwrite(str.data(), 1, str.size(), nullFile);
+    });
+    
+    RunBenchmark("Json buffer", iterations, [&]()
+    {
+        return DS::WriteStructured(trace, DS::StructuredFormat::Json, buffer, sizeof(buffer));
+    });
+    
+    RunBenchmark("Logfmt buffer", iterations, [&]()
+    {
+        return DS::WriteStructured(trace, DS::StructuredFormat::Logfmt, buffer, sizeof(buffer));
+    });
+    
+    RunBenchmark("Json FILE*", iterations, [&]()
+    {
+        DS::WriteStructured(trace, DS::StructuredFormat::Json, nullFile);
+        return jsonSize;
+    });
+    
+    RunBenchmark("Logfmt FILE*", iterations, [&]()
+    {
+        DS::WriteStructured(trace, DS::StructuredFormat::Logfmt, nullFile);
+        return logfmtSize;
+    });
+    
+    std::fclose(nullFile);
+    return 0;
+}
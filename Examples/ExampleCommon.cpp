@@ -1,8 +1,11 @@
 #include "TryExamples.hpp"
 #include "DSResult/DSResult.hpp"
+#include "DSResult/StructuredWriter.hpp"
 
 #include <iostream>
+#include <stdexcept>
 #include <string>
+#include <system_error>
 
 
 DS::Result<int> FunctionWithMsg()
@@ -121,12 +124,146 @@ DS::Result<void> AssertExample(int assertIndex)
     return {};
 }
 
+DS::Result<int> FunctionWithContextKeyValue(int requestId)
+{
+    DS_UNWRAP_DECL_CTX(int resultInt, FunctionWithMsg(), DS_CTX_KV("requestId", requestId));
+    return resultInt;
+}
+
+DS::Result<void> FunctionWithContextCapture()
+{
+    std::string fileName = "config.json";
+    DS::Result<int> result = FunctionWithContextKeyValue(42);
+    DS_CHECK_CTX(result, DS_CTX_CAPTURE("file", fileName));
+    return {};
+}
+
+DS::Result<void> FunctionWithContext()
+{
+    DS_UNWRAP_VOID_CTX(FunctionWithContextCapture(), DS_CTX("Loading config"));
+    return {};
+}
+
+DS::Result<int> FunctionWithCombinators(int testVar)
+{
+    return FunctionWithAssert(testVar)
+        .DS_MAP([](int value) { return value + 1; })
+        .DS_AND_THEN(FunctionWithAssert)
+        .DS_MAP_ERROR([](DS::ErrorTrace error) { error.ErrorCode = 7; return error; });
+}
+
+DS_CONSTEXPR DS::StaticResult<int> ValidatePort(int port)
+{
+    DS_STATIC_ASSERT_GT(port, 0);
+    DS_STATIC_ASSERT_LT_EQ_EC(port, 65535, 2);
+    return port;
+}
+
+#if __cplusplus >= 201402L
+    static_assert(ValidatePort(8080).HasValue(), "Port should be valid");
+    static_assert(!ValidatePort(0).HasValue(), "Port should be invalid");
+#endif
+
+void CollectUserErrors(int age, const std::string& name, int port, DS::ErrorList& errors)
+{
+    DS_COLLECT_ASSERT_GT_EQ(errors, age, 0);
+    DS_COLLECT_ASSERT_FALSE_EC(errors, name.empty(), 4);
+    DS_COLLECT_CHECK(errors, ValidatePort(port).ToResult());
+}
+
+DS::Result<void> ValidateUser(int age, const std::string& name, int port)
+{
+    DS::ErrorList errors;
+    CollectUserErrors(age, name, port, errors);
+    DS_CHECK_LIST(errors);
+    return {};
+}
+
+DS::Result<int> WalkTree(int depth)
+{
+    if(depth == 0)
+        return DS_ERROR_MSG("Leaf not found");
+    DS_UNWRAP_DECL(int result, WalkTree(depth - 1));
+    return result;
+}
+
+DS::Result<int> ParseList(int depth);
+
+DS::Result<int> ParseValue(int depth)
+{
+    if(depth == 0)
+        return DS_ERROR_MSG("Unexpected end of input");
+    DS_UNWRAP_DECL(int result, ParseList(depth - 1));
+    return result;
+}
+
+DS::Result<int> ParseList(int depth)
+{
+    DS_UNWRAP_DECL(int result, ParseValue(depth));
+    return result;
+}
+
+DS::Result<void> VerifyBlock(const std::vector<int>& decoded, const std::vector<int>& expected)
+{
+    DS_ASSERT_RANGE_EQ(decoded, expected);
+    return {};
+}
+
+DS::Result<void> VerifyChecksum(const unsigned char* block, const unsigned char* expected)
+{
+    DS_ASSERT_BYTES_EQ_EC(block, expected, 32, 6);
+    return {};
+}
+
+//Error codes of a third party parser
+struct ParserCategory : public std::error_category
+{
+    const char* name() const noexcept override { return "parser"; }
+    
+    std::string message(int value) const override
+    {
+        return value == 1 ? "unexpected end of input" : "unknown error";
+    }
+};
+
+const std::error_category& GetParserCategory()
+{
+    static ParserCategory category;
+    return category;
+}
+
+int ThirdPartyParseDigit(const std::string& text)
+{
+    if(text.empty())
+        throw std::system_error(1, GetParserCategory());
+    if(text[0] < '0' || text[0] > '9')
+        throw std::invalid_argument("Invalid digit " + text.substr(0, 1));
+    return text[0] - '0';
+}
+
+DS::Result<int> ParseDigit(const std::string& text)
+{
+    return DS_CATCH([&]() { return ThirdPartyParseDigit(text); });
+}
+
+DS::Result<void> FlushParser(int status)
+{
+    std::error_code errorCode(status, GetParserCategory());
+    DS_CHECK_ERROR_CODE(errorCode);
+    return {};
+}
+
 int main()
 {
     std::string resultString;
     int myInt = 0;
     (void)myInt;
     
+    #if DS_USE_REALTIME_POOL
+        //Errors on a thread without a reserved pool are truncated
+        DS::ReserveErrorPool(256 * 1024);
+    #endif
+    
     #define APPEND_ERROR() \
         resultString += DS_APPEND_TRACE(DS_TMP_ERROR).ToString() + "\n---------\n";
     
@@ -151,6 +288,82 @@ int main()
         resultString += "i == " + std::to_string(i) + ":\n";
         AssertExample(i).DS_TRY_ACT(APPEND_ERROR());                    //Pass first, fail rest
     }
+    resultString += "9:\n";
+    FunctionWithContext().DS_TRY_ACT(APPEND_ERROR());                   //Fail
+    resultString += "10:\n";
+    {
+        DS::Result<void> result = FunctionWithContext();
+        char buffer[1024];
+        DS::WriteStructured(result.Error(), DS::StructuredFormat::Json, buffer, sizeof(buffer));
+        resultString += std::string(buffer) + "\n";
+        DS::WriteStructured(result.Error(), DS::StructuredFormat::Logfmt, buffer, sizeof(buffer));
+        resultString += std::string(buffer) + "\n";
+        
+        result = AssertExample(3);
+        DS::WriteStructured(result.Error(), DS::StructuredFormat::Json, buffer, sizeof(buffer));
+        resultString += std::string(buffer) + "\n";
+        DS::WriteStructured(result.Error(), DS::StructuredFormat::Logfmt, buffer, sizeof(buffer));
+        resultString += std::string(buffer) + "\n";
+    }
+    resultString += "11:\n";
+    intResult = FunctionWithCombinators(2).DS_TRY_ACT(APPEND_ERROR());  //Pass
+    resultString += std::to_string(intResult) + "\n";
+    intResult = FunctionWithCombinators(0).DS_TRY_ACT(APPEND_ERROR());  //Fail
+    intResult = FunctionWithCombinators(0).DS_OR_ELSE([](DS::ErrorTrace) { return -1; }).Value();
+    resultString += std::to_string(intResult) + "\n";
+    resultString += "12:\n";
+    intResult = ValidatePort(443).ToResult().DS_TRY_ACT(APPEND_ERROR());      //Pass
+    resultString += std::to_string(intResult) + "\n";
+    intResult = ValidatePort(70000).ToResult().DS_TRY_ACT(APPEND_ERROR());    //Fail
+    resultString += "13:\n";
+    ValidateUser(30, "Alice", 443).DS_TRY_ACT(APPEND_ERROR());    //Pass
+    ValidateUser(-1, "Alice", 443).DS_TRY_ACT(APPEND_ERROR());    //Fail
+    {
+        //Rendered directly, a long list doesn't fit in the message of one error in real-time mode
+        DS::ErrorList errors;
+        CollectUserErrors(-1, "", 70000, errors);
+        resultString += errors.ToString() + "\n";
+        
+        char buffer[1024];
+        DS::WriteStructured(errors, DS::StructuredFormat::Logfmt, buffer, sizeof(buffer));
+        resultString += std::string(buffer) + "\n";
+    }
+    resultString += "14:\n";
+    WalkTree(1000).DS_TRY_ACT(APPEND_ERROR());
+    {
+        DS::Result<int> result = ParseValue(1000);
+        resultString += std::to_string(result.Error().Stack.size()) + " frames stored, " + 
+                        std::to_string(result.Error().OmittedFrames) + " frames omitted\n";
+    }
+    resultString += "15:\n";
+    {
+        std::vector<int> decoded;
+        for(int i = 0; i < 16; ++i)
+            decoded.push_back(i);
+        
+        std::vector<int> expected = decoded;
+        VerifyBlock(decoded, expected).DS_TRY_ACT(APPEND_ERROR());  //Pass
+        expected[10] = 0;
+        VerifyBlock(decoded, expected).DS_TRY_ACT(APPEND_ERROR());  //Fail
+        
+        unsigned char block[32] = {};
+        unsigned char expectedBlock[32] = {};
+        expectedBlock[20] = 0xff;
+        VerifyChecksum(block, expectedBlock).DS_TRY_ACT(APPEND_ERROR());  //Fail
+    }
+    resultString += "16:\n";
+    {
+        int digit = ParseDigit("7").DS_TRY_ACT(APPEND_ERROR());                           //Pass
+        resultString += std::to_string(digit) + "\n";
+        ParseDigit("").DS_TRY_ACT(APPEND_ERROR());                                          //Fail
+        ParseDigit("x").DS_TRY_ACT(APPEND_ERROR());                                         //Fail
+        FlushParser(0).DS_TRY_ACT(APPEND_ERROR());                                          //Pass
+        FlushParser(2).DS_TRY_ACT(APPEND_ERROR());                                          //Fail
+        
+        char buffer[256];
+        DS::WriteStructured(FlushParser(1).Error(), DS::StructuredFormat::Json, buffer, 256);
+        resultString += std::string(buffer) + "\n";
+    }
     
     std::cout << resultString << std::endl;
     
@@ -161,36 +374,36 @@ Error:
 Error Code: 5
 
 Stack trace:
-  at ExampleCommon.cpp:17 in FunctionWithAssert()
-  at ExampleCommon.cpp:137 in main()
+  at ExampleCommon.cpp:20 in FunctionWithAssert()
+  at ExampleCommon.cpp:274 in main()
 ---------
 3:
 Error:
   Something wrong: 12345
 
 Stack trace:
-  at ExampleCommon.cpp:11 in FunctionWithMsg()
-  at ExampleCommon.cpp:23 in FunctionWithUnwrapDecl()
-  at ExampleCommon.cpp:139 in main()
+  at ExampleCommon.cpp:14 in FunctionWithMsg()
+  at ExampleCommon.cpp:26 in FunctionWithUnwrapDecl()
+  at ExampleCommon.cpp:276 in main()
 ---------
 4:
 Error:
   Something wrong: 12345
 
 Stack trace:
-  at ExampleCommon.cpp:11 in FunctionWithMsg()
-  at ExampleCommon.cpp:31 in FunctionWithUnwrapAssign()
-  at ExampleCommon.cpp:141 in main()
+  at ExampleCommon.cpp:14 in FunctionWithMsg()
+  at ExampleCommon.cpp:34 in FunctionWithUnwrapAssign()
+  at ExampleCommon.cpp:278 in main()
 ---------
 5:
 Error:
   Something wrong: 12345
 
 Stack trace:
-  at ExampleCommon.cpp:11 in FunctionWithMsg()
-  at ExampleCommon.cpp:31 in FunctionWithUnwrapAssign()
-  at ExampleCommon.cpp:38 in FunctionWithUnwrapVoid()
-  at ExampleCommon.cpp:143 in main()
+  at ExampleCommon.cpp:14 in FunctionWithMsg()
+  at ExampleCommon.cpp:34 in FunctionWithUnwrapAssign()
+  at ExampleCommon.cpp:41 in FunctionWithUnwrapVoid()
+  at ExampleCommon.cpp:280 in main()
 ---------
 6:
 Error:
@@ -199,7 +412,7 @@ Error:
 Stack trace:
   at TryExamples.cpp:8 in FunctionWithMsg()
   at TryExamples.cpp:14 in FunctionWithTry()
-  at ExampleCommon.cpp:145 in main()
+  at ExampleCommon.cpp:282 in main()
 ---------
 7:
 0
@@ -210,65 +423,187 @@ Error:
   Expression "0 == 1" has failed.
 
 Stack trace:
-  at ExampleCommon.cpp:95 in AssertExample()
-  at ExampleCommon.cpp:152 in main()
+  at ExampleCommon.cpp:98 in AssertExample()
+  at ExampleCommon.cpp:289 in main()
 ---------
 i == 2:
 Error:
   Expression "1 == 0" has failed.
 
 Stack trace:
-  at ExampleCommon.cpp:98 in AssertExample()
-  at ExampleCommon.cpp:152 in main()
+  at ExampleCommon.cpp:101 in AssertExample()
+  at ExampleCommon.cpp:289 in main()
 ---------
 i == 3:
 Error:
   Expression "5 == 4" has failed.
 
 Stack trace:
-  at ExampleCommon.cpp:101 in AssertExample()
-  at ExampleCommon.cpp:152 in main()
+  at ExampleCommon.cpp:104 in AssertExample()
+  at ExampleCommon.cpp:289 in main()
 ---------
 i == 4:
 Error:
   Expression "5 != 5" has failed.
 
 Stack trace:
-  at ExampleCommon.cpp:104 in AssertExample()
-  at ExampleCommon.cpp:152 in main()
+  at ExampleCommon.cpp:107 in AssertExample()
+  at ExampleCommon.cpp:289 in main()
 ---------
 i == 5:
 Error:
   Expression "5 > 6" has failed.
 
 Stack trace:
-  at ExampleCommon.cpp:107 in AssertExample()
-  at ExampleCommon.cpp:152 in main()
+  at ExampleCommon.cpp:110 in AssertExample()
+  at ExampleCommon.cpp:289 in main()
 ---------
 i == 6:
 Error:
   Expression "5 >= 6" has failed.
 
 Stack trace:
-  at ExampleCommon.cpp:110 in AssertExample()
-  at ExampleCommon.cpp:152 in main()
+  at ExampleCommon.cpp:113 in AssertExample()
+  at ExampleCommon.cpp:289 in main()
 ---------
 i == 7:
 Error:
   Expression "5 < 4" has failed.
 
 Stack trace:
-  at ExampleCommon.cpp:113 in AssertExample()
-  at ExampleCommon.cpp:152 in main()
+  at ExampleCommon.cpp:116 in AssertExample()
+  at ExampleCommon.cpp:289 in main()
 ---------
 i == 8:
 Error:
   Expression "5 <= 4" has failed.
 
 Stack trace:
-  at ExampleCommon.cpp:116 in AssertExample()
-  at ExampleCommon.cpp:152 in main()
+  at ExampleCommon.cpp:119 in AssertExample()
+  at ExampleCommon.cpp:289 in main()
+---------
+9:
+Error:
+  Something wrong: 12345
+
+Stack trace:
+  at ExampleCommon.cpp:14 in FunctionWithMsg()
+  at ExampleCommon.cpp:129 in FunctionWithContextKeyValue()
+    - requestId: 42
+  at ExampleCommon.cpp:137 in FunctionWithContextCapture()
+    - file: "config.json"
+  at ExampleCommon.cpp:143 in FunctionWithContext()
+    - Loading config
+  at ExampleCommon.cpp:292 in main()
+---------
+10:
+{"message":"Something wrong: 12345","code":0,"frames":[{"function":"FunctionWithMsg","file":"ExampleCommon.cpp","line":14},{"function":"FunctionWithContextKeyValue","file":"ExampleCommon.cpp","line":129,"context":[{"key":"requestId","value":42}]},{"function":"FunctionWithContextCapture","file":"ExampleCommon.cpp","line":137,"context":[{"key":"file","value":"config.json"}]},{"function":"FunctionWithContext","file":"ExampleCommon.cpp","line":143,"context":[{"note":"Loading config"}]}]}
+message="Something wrong: 12345" code=0 frame.0.function=FunctionWithMsg frame.0.file=ExampleCommon.cpp frame.0.line=14 frame.1.function=FunctionWithContextKeyValue frame.1.file=ExampleCommon.cpp frame.1.line=129 frame.1.ctx.requestId=42 frame.2.function=FunctionWithContextCapture frame.2.file=ExampleCommon.cpp frame.2.line=137 frame.2.ctx.file=config.json frame.3.function=FunctionWithContext frame.3.file=ExampleCommon.cpp frame.3.line=143 frame.3.note="Loading config"
+{"message":"Expression \"5 == 4\" has failed.","code":0,"frames":[{"function":"AssertExample","file":"ExampleCommon.cpp","line":104}]}
+message="Expression \"5 == 4\" has failed." code=0 frame.0.function=AssertExample frame.0.file=ExampleCommon.cpp frame.0.line=104
+11:
+10
+Error:
+  Expression "0 != 0" has failed.
+Error Code: 7
+
+Stack trace:
+  at ExampleCommon.cpp:20 in FunctionWithAssert()
+  at ExampleCommon.cpp:150 in FunctionWithCombinators()
+  at ExampleCommon.cpp:151 in FunctionWithCombinators()
+  at ExampleCommon.cpp:152 in FunctionWithCombinators()
+  at ExampleCommon.cpp:311 in main()
+---------
+-1
+12:
+443
+Error:
+  Expression "port <= 65535" has failed.
+Error Code: 2
+
+Stack trace:
+  at ExampleCommon.cpp:158 in ValidatePort()
+  at ExampleCommon.cpp:317 in main()
+---------
+13:
+Error:
+  1 error:
+  [1] Expression "-1 >= 0" has failed.
+      at ExampleCommon.cpp:169 in CollectUserErrors()
+
+Stack trace:
+  at ExampleCommon.cpp:178 in ValidateUser()
+  at ExampleCommon.cpp:320 in main()
+---------
+3 errors:
+  [1] Expression "-1 >= 0" has failed.
+      at ExampleCommon.cpp:169 in CollectUserErrors()
+  [2] Expression "1 == 0" has failed.
+      Error Code: 4
+      at ExampleCommon.cpp:170 in CollectUserErrors()
+  [3] Expression "port <= 65535" has failed.
+      Error Code: 2
+      at ExampleCommon.cpp:158 in ValidatePort()
+      at ExampleCommon.cpp:171 in CollectUserErrors()
+message="Expression \"-1 >= 0\" has failed." code=0 frame.0.function=CollectUserErrors frame.0.file=ExampleCommon.cpp frame.0.line=169
+message="Expression \"1 == 0\" has failed." code=4 frame.0.function=CollectUserErrors frame.0.file=ExampleCommon.cpp frame.0.line=170
+message="Expression \"port <= 65535\" has failed." code=2 frame.0.function=ValidatePort frame.0.file=ExampleCommon.cpp frame.0.line=158 frame.1.function=CollectUserErrors frame.1.file=ExampleCommon.cpp frame.1.line=171
+14:
+Error:
+  Leaf not found
+
+Stack trace:
+  at ExampleCommon.cpp:185 in WalkTree()
+  at ExampleCommon.cpp:186 in WalkTree() x 1000
+  at ExampleCommon.cpp:332 in main()
+---------
+97 frames stored, 1904 frames omitted
+15:
+Error:
+  Ranges "decoded" and "expected" differ at index 10 (sizes 16 and 16)
+  left  [2, 16): ... 2, 3, 4, 5, 6, 7, 8, 9, [10], 11, 12, 13, 14, 15
+  right [2, 16): ... 2, 3, 4, 5, 6, 7, 8, 9, [0], 11, 12, 13, 14, 15
+
+Stack trace:
+  at ExampleCommon.cpp:208 in VerifyBlock()
+  at ExampleCommon.cpp:347 in main()
+---------
+Error:
+  Bytes "block" and "expected" differ at offset 20 of 32
+  left  [12, 29): ... 00 00 00 00 00 00 00 00 [00] 00 00 00 00 00 00 00 00 ...
+  right [12, 29): ... 00 00 00 00 00 00 00 00 [ff] 00 00 00 00 00 00 00 00 ...
+Error Code: 6
+
+Stack trace:
+  at ExampleCommon.cpp:214 in VerifyChecksum()
+  at ExampleCommon.cpp:352 in main()
+---------
+16:
+7
+Error:
+  parser: unexpected end of input
+Error Code: 1
+
+Stack trace:
+  at ExampleCommon.cpp:246 in ParseDigit()
+  at ExampleCommon.cpp:358 in main()
+---------
+Error:
+  Invalid digit x
+
+Stack trace:
+  at ExampleCommon.cpp:246 in ParseDigit()
+  at ExampleCommon.cpp:359 in main()
+---------
+Error:
+  parser: unknown error
+Error Code: 2
+
+Stack trace:
+  at ExampleCommon.cpp:252 in FlushParser()
+  at ExampleCommon.cpp:361 in main()
 ---------
+{"message":"unexpected end of input","code":1,"category":"parser","frames":[{"function":"FlushParser","file":"ExampleCommon.cpp","line":252}]}
 )";
 
     
@@ -0,0 +1 @@
+#include "./ExampleCommon.cpp"
@@ -0,0 +1,313 @@
+#ifndef DS_RESULT_ASYNC_ERROR_SINK_HPP
+#define DS_RESULT_ASYNC_ERROR_SINK_HPP
+
+#include "DSResult.hpp"
+#include "StructuredWriter.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <new>
+#include <thread>
+
+//Milliseconds the writer thread waits for a wake up when the queue is empty before checking the
+//queue again. A push only misses its wake up when the writer has checked the queue but hasn't 
+//started waiting yet, which delays the write by up to this long.
+#ifndef DS_ASYNC_SINK_IDLE_MS
+    #define DS_ASYNC_SINK_IDLE_MS 10
+#endif
+
+namespace DS
+{
+    enum class SinkOverflowPolicy : unsigned char
+    {
+        //The pushed error is dropped and the queued errors are kept
+        DropNewest,
+
+        //The oldest queued error is dropped on the pushing thread to make room for the pushed one
+        DropOldest
+    };
+
+    //Bounded multi producer queue of error traces, formatted and written by a background thread.
+    //`Push()` moves the trace into a cell claimed with a single compare and swap (Vyukov's bounded
+    //queue), with no formatting or allocation on the fast path. Waking the idle writer thread can
+    //take the internal lock of the condition variable or make a futex syscall. When the queue is 
+    //full, errors are dropped according to `Policy` and counted in `GetDroppedCount()`. With 
+    //`DropOldest`, the evicted error is destroyed on the pushing thread.
+    struct AsyncErrorSink
+    {
+        //Called on the writer thread for each error, must not throw
+        typedef void (*WriteFunction)(void* target, const ErrorTrace& trace);
+
+        struct Cell
+        {
+            std::atomic<std::size_t> Sequence;
+            alignas(ErrorTrace) unsigned char Storage[sizeof(ErrorTrace)];
+
+            inline ErrorTrace& Trace()
+            {
+                return *reinterpret_cast<ErrorTrace*>(&Storage);
+            }
+        };
+
+        Cell* Cells;
+        std::size_t Mask;
+        SinkOverflowPolicy Policy;
+        WriteFunction Write;
+        void* Target;
+        std::FILE* File;
+        StructuredFormat Format;
+
+        //The positions are written by different threads, keep them on separate cache lines
+        char PaddingBefore[64];
+        std::atomic<std::size_t> EnqueuePosition;
+        char PaddingEnqueue[64];
+        std::atomic<std::size_t> DequeuePosition;
+        char PaddingDequeue[64];
+
+        std::atomic<std::uint64_t> WrittenCount;
+        std::atomic<std::uint64_t> DroppedCount;
+        std::atomic<bool> Stopping;
+        std::atomic<bool> WriterIdle;
+        std::mutex IdleMutex;
+        std::condition_variable IdleCondition;
+        std::thread Writer;
+
+        //`capacity` is rounded up to a power of 2
+        inline AsyncErrorSink(  std::size_t capacity,
+                                WriteFunction write,
+                                void* target,
+                                SinkOverflowPolicy policy = SinkOverflowPolicy::DropNewest) :
+                                    Cells(nullptr),
+                                    Mask(0),
+                                    Policy(policy),
+                                    Write(write),
+                                    Target(target),
+                                    File(nullptr),
+                                    Format(StructuredFormat::Json),
+                                    EnqueuePosition(0),
+                                    DequeuePosition(0),
+                                    WrittenCount(0),
+                                    DroppedCount(0),
+                                    Stopping(false),
+                                    WriterIdle(false)
+        {
+            InternalStart(capacity);
+        }
+
+        //Writes each error to `file` as a `WriteStructured()` record, flushed after each batch
+        inline AsyncErrorSink(  std::size_t capacity,
+                                std::FILE* file,
+                                StructuredFormat format,
+                                SinkOverflowPolicy policy = SinkOverflowPolicy::DropNewest) :
+                                    Cells(nullptr),
+                                    Mask(0),
+                                    Policy(policy),
+                                    Write(InternalWriteStructured),
+                                    Target(this),
+                                    File(file),
+                                    Format(format),
+                                    EnqueuePosition(0),
+                                    DequeuePosition(0),
+                                    WrittenCount(0),
+                                    DroppedCount(0),
+                                    Stopping(false),
+                                    WriterIdle(false)
+        {
+            InternalStart(capacity);
+        }
+
+        AsyncErrorSink(const AsyncErrorSink&) = delete;
+        AsyncErrorSink& operator=(const AsyncErrorSink&) = delete;
+
+        //Writes the queued errors before returning
+        inline ~AsyncErrorSink()
+        {
+            Stop();
+
+            //Errors pushed after `Stop()` are never written
+            ErrorTrace trace;
+            while(InternalPop(trace))
+                DroppedCount.fetch_add(1, std::memory_order_relaxed);
+            delete[] Cells;
+        }
+
+        //Returns false if the error is dropped. It is moved from either way.
+        inline bool Push(ErrorTrace&& trace)
+        {
+            std::size_t position = EnqueuePosition.load(std::memory_order_relaxed);
+            while(true)
+            {
+                Cell& cell = Cells[position & Mask];
+                std::size_t sequence = cell.Sequence.load(std::memory_order_acquire);
+                std::ptrdiff_t difference = (std::ptrdiff_t)sequence - (std::ptrdiff_t)position;
+
+                if(difference == 0)
+                {
+                    if(EnqueuePosition.compare_exchange_weak(   position,
+                                                                position + 1,
+                                                                std::memory_order_relaxed))
+                    {
+                        new (&cell.Storage) ErrorTrace(std::move(trace));
+
+                        //Only the first push after the writer went idle wakes it up. Sequentially
+                        //consistent with the writer going idle in `InternalRun()`: either this
+                        //sees the writer idle, or the writer sees this error before it waits.
+                        cell.Sequence.store(position + 1, std::memory_order_seq_cst);
+                        if(WriterIdle.exchange(false, std::memory_order_seq_cst))
+                            IdleCondition.notify_one();
+                        return true;
+                    }
+                }
+                //Full, the cell still holds an error from the previous lap
+                else if(difference < 0)
+                {
+                    if(Policy == SinkOverflowPolicy::DropNewest)
+                    {
+                        ErrorTrace dropped(std::move(trace));
+                        DroppedCount.fetch_add(1, std::memory_order_relaxed);
+                        return false;
+                    }
+
+                    ErrorTrace oldest;
+                    if(InternalPop(oldest))
+                        DroppedCount.fetch_add(1, std::memory_order_relaxed);
+                    position = EnqueuePosition.load(std::memory_order_relaxed);
+                }
+                else
+                    position = EnqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+
+        //Writes the queued errors and stops the writer thread. Called by the destructor.
+        inline void Stop()
+        {
+            if(!Writer.joinable())
+                return;
+
+            Stopping.store(true, std::memory_order_release);
+            {
+                std::lock_guard<std::mutex> lock(IdleMutex);
+                IdleCondition.notify_one();
+            }
+            Writer.join();
+        }
+
+        //Errors accepted by `Push()`, including the ones dropped later by `DropOldest`
+        inline std::uint64_t GetPushedCount() const
+        {
+            return EnqueuePosition.load(std::memory_order_relaxed);
+        }
+
+        inline std::uint64_t GetWrittenCount() const
+        {
+            return WrittenCount.load(std::memory_order_relaxed);
+        }
+
+        inline std::uint64_t GetDroppedCount() const
+        {
+            return DroppedCount.load(std::memory_order_relaxed);
+        }
+
+        inline void InternalStart(std::size_t capacity)
+        {
+            std::size_t size = 2;
+            while(size < capacity)
+                size *= 2;
+
+            Cells = new Cell[size];
+            for(std::size_t i = 0; i < size; ++i)
+                Cells[i].Sequence.store(i, std::memory_order_relaxed);
+            Mask = size - 1;
+            Writer = std::thread(&AsyncErrorSink::InternalRun, this);
+        }
+
+        //Used by the writer thread, and by pushing threads to drop the oldest error
+        inline bool InternalPop(ErrorTrace& outTrace)
+        {
+            std::size_t position = DequeuePosition.load(std::memory_order_relaxed);
+            while(true)
+            {
+                Cell& cell = Cells[position & Mask];
+                std::size_t sequence = cell.Sequence.load(std::memory_order_acquire);
+                std::ptrdiff_t difference = (std::ptrdiff_t)sequence -
+                                            (std::ptrdiff_t)(position + 1);
+
+                if(difference == 0)
+                {
+                    if(DequeuePosition.compare_exchange_weak(   position,
+                                                                position + 1,
+                                                                std::memory_order_relaxed))
+                    {
+                        outTrace = std::move(cell.Trace());
+                        cell.Trace().~ErrorTrace();
+                        cell.Sequence.store(position + Mask + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                //Empty, or the next cell is still being pushed
+                else if(difference < 0)
+                    return false;
+                else
+                    position = DequeuePosition.load(std::memory_order_relaxed);
+            }
+        }
+
+        inline bool InternalIsEmpty() const
+        {
+            std::size_t position = DequeuePosition.load(std::memory_order_relaxed);
+            return Cells[position & Mask].Sequence.load(std::memory_order_seq_cst) != position + 1;
+        }
+
+        inline void InternalRun()
+        {
+            ErrorTrace trace;
+            while(true)
+            {
+                bool wrote = false;
+                while(InternalPop(trace))
+                {
+                    Write(Target, trace);
+                    WrittenCount.fetch_add(1, std::memory_order_relaxed);
+                    wrote = true;
+                }
+
+                if(wrote && File != nullptr)
+                    std::fflush(File);
+
+                if(Stopping.load(std::memory_order_acquire))
+                {
+                    if(InternalIsEmpty())
+                        return;
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(IdleMutex);
+                WriterIdle.store(true, std::memory_order_seq_cst);
+                IdleCondition.wait_for( lock,
+                                        std::chrono::milliseconds(DS_ASYNC_SINK_IDLE_MS),
+                                        [this]()
+                                        {
+                                            return  Stopping.load(std::memory_order_acquire) ||
+                                                    !InternalIsEmpty();
+                                        });
+                WriterIdle.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        static inline void InternalWriteStructured(void* target, const ErrorTrace& trace)
+        {
+            AsyncErrorSink* sink = static_cast<AsyncErrorSink*>(target);
+            WriteStructured(trace, sink->Format, sink->File);
+        }
+    };
+}
+
+//Appends the current frame and pushes `errorTrace` (i.e. `DS_TMP_ERROR`) to `sink` by move
+#define DS_PUSH_ERROR(sink, errorTrace) (sink).Push(std::move(DS_APPEND_TRACE(errorTrace)))
+
+#endif
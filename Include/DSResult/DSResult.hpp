@@ -4,11 +4,22 @@
 #if !defined(DS_USE_TL_EXPECTED) && \
     !defined(DS_USE_EXPECTED_LITE) && \
     !defined(DS_USE_STD_EXPECTED) && \
+    !defined(DS_USE_NATIVE_EXPECTED) && \
     !defined(DS_USE_CUSTOM_EXPECTED)
     
     #define DS_USE_TL_EXPECTED 1
 #endif
 
+//`DS_CATCH` only catches exceptions when they are enabled
+#if !defined(DS_NO_EXCEPTIONS) && \
+    (defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND))
+    #define INTERNAL_DS_HAS_EXCEPTIONS 1
+    #include <exception>
+    #include <new>
+#else
+    #define INTERNAL_DS_HAS_EXCEPTIONS 0
+#endif
+
 #if defined(DS_USE_TL_EXPECTED) && DS_USE_TL_EXPECTED
     #include "tl/expected.hpp"
     #define DS_EXPECTED_TYPE tl::expected
@@ -21,6 +32,10 @@
     #include <expected>
     #define DS_EXPECTED_TYPE std::expected
     #define DS_UNEXPECTED_TYPE std::unexpected
+#elif defined(DS_USE_NATIVE_EXPECTED) && DS_USE_NATIVE_EXPECTED
+    #include "NativeExpected.hpp"
+    #define DS_EXPECTED_TYPE DS::NativeExpected
+    #define DS_UNEXPECTED_TYPE DS::NativeUnexpected
 #elif defined(DS_USE_CUSTOM_EXPECTED) && DS_USE_CUSTOM_EXPECTED
     //User custom expected
     #if !defined(DS_EXPECTED_TYPE) || !defined(DS_UNEXPECTED_TYPE)
@@ -29,7 +44,7 @@
     #endif
 #else
     static_assert(false,    "DS_USE_TL_EXPECTED or DS_USE_EXPECTED_LITE or DS_USE_STD_EXPECTED or "
-                            "DS_USE_CUSTOM_EXPECTED must be defined");
+                            "DS_USE_NATIVE_EXPECTED or DS_USE_CUSTOM_EXPECTED must be defined");
 #endif
 
 #if __cplusplus >= 202002L
@@ -40,6 +55,13 @@
     #define INTERNAL_DS_FUNC_CONSTEVAL
 #endif
 
+//Functions with more than a return statement can only be constexpr since C++14
+#if __cplusplus >= 201402L
+    #define DS_CONSTEXPR constexpr
+#else
+    #define DS_CONSTEXPR
+#endif
+
 #if DS_NO_PATH
     #define DS_PATH "(Private File)"
 #else
@@ -50,10 +72,71 @@
     #include "../../External/debugbreak/debugbreak.h"
 #endif
 
+#if DS_USE_USDT
+    #include <sys/sdt.h>
+#endif
+
+#if DS_USE_TRACE_HOOKS
+    #include <atomic>
+#endif
+
+#if DS_USE_REALTIME_POOL
+    #include "RealtimePool.hpp"
+#endif
+
+//Size of the inline buffer for captured context strings, including the null terminator
+#ifndef DS_CONTEXT_INLINE_SIZE
+    #define DS_CONTEXT_INLINE_SIZE 32
+#endif
+
+//Number of frames reserved when an error trace is created. Contexts are reserved to the same 
+//capacity as the frames when they need to grow, so attaching a context per frame doesn't grow 
+//them one by one. Not used in real-time mode.
+#ifndef DS_TRACE_RESERVE_FRAMES
+    #define DS_TRACE_RESERVE_FRAMES 8
+#endif
+
+//Maximum number of frames stored for an error trace, 0 for unlimited. When reached, the oldest 
+//frames after the first `DS_TRACE_HEAD_FRAMES` frames are dropped and counted as omitted. When 
+//there's nothing to drop (e.g. with a depth of 1), the appended frame is omitted instead.
+#ifndef DS_MAX_TRACE_DEPTH
+    #define DS_MAX_TRACE_DEPTH 0
+#endif
+
+#ifndef DS_TRACE_HEAD_FRAMES
+    #define DS_TRACE_HEAD_FRAMES 16
+#endif
+
+//When enabled, appending the same frame as the last one increments its `Repeat` instead of 
+//storing it again, for example when an error is propagated through recursion
+#ifndef DS_MERGE_REPEATED_FRAMES
+    #define DS_MERGE_REPEATED_FRAMES 0
+#endif
+
+//Number of elements (or bytes) shown on each side of the first difference by 
+//`DS_ASSERT_RANGE_EQ` and `DS_ASSERT_BYTES_EQ`
+#ifndef DS_ASSERT_WINDOW
+    #define DS_ASSERT_WINDOW 8
+#endif
+
+#if !defined(DS_NO_SIMD) && \
+    (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #define INTERNAL_DS_USE_SSE2 1
+    #include <emmintrin.h>
+#else
+    #define INTERNAL_DS_USE_SSE2 0
+#endif
+
 #include <string>
 #include <vector>
 #include <type_traits>
 #include <utility>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <system_error>
+#include <cerrno>
 
 namespace
 {
@@ -82,13 +165,18 @@ namespace DS
         const char* Function;
         const char* File;
         int Line;
+        
+        //Number of consecutive times this frame is appended when `DS_MERGE_REPEATED_FRAMES` is 
+        //enabled, for example by recursion
+        int Repeat;
 
         inline INTERNAL_DS_FUNC_CONSTEVAL
         TraceElement(   const char* func, 
                         const char* filepath, 
                         const int line) :   Function(func),
                                             File(filepath),
-                                            Line(line)
+                                            Line(line),
+                                            Repeat(1)
         {}
 
         inline TraceElement& operator=(const TraceElement& other)
@@ -98,109 +186,569 @@ namespace DS
                 Function = other.Function;
                 File = other.File;
                 Line = other.Line;
+                Repeat = other.Repeat;
             }
             return *this;
         }
 
-        inline TraceElement(const TraceElement& other)
-        {
-            *this = other;
-        }
+        inline DS_CONSTEXPR 
+        TraceElement(const TraceElement& other) :   Function(other.Function),
+                                                    File(other.File),
+                                                    Line(other.Line),
+                                                    Repeat(other.Repeat)
+        {}
         
         inline TraceElement& operator=(TraceElement&& other)
         {
             Function = other.Function;
             File = other.File;
             Line = other.Line;
+            Repeat = other.Repeat;
             return *this;
         }
         
-        inline TraceElement(TraceElement&& other)
+        inline DS_CONSTEXPR 
+        TraceElement(TraceElement&& other) :    Function(other.Function),
+                                                File(other.File),
+                                                Line(other.Line),
+                                                Repeat(other.Repeat)
+        {}
+        
+        inline bool SameSite(const TraceElement& other) const
         {
-            *this = other;
+            return  Line == other.Line &&
+                    (Function == other.Function || std::strcmp(Function, other.Function) == 0) &&
+                    (File == other.File || std::strcmp(File, other.File) == 0);
         }
 
         inline std::string ToString() const 
         {
             return  std::string(File) + ":" + std::to_string(Line) + " in " + std::string(Function) + 
-                    "()";
+                    "()" + (Repeat > 1 ? " x " + std::to_string(Repeat) : "");
+        }
+    };
+
+    struct ErrorTrace;
+    
+    //Override the events of interest and register with `DS::SetTraceHooks()`.
+    //Only called when `DS_USE_TRACE_HOOKS` is enabled.
+    struct TraceHooks
+    {
+        virtual ~TraceHooks() {}
+        
+        //A new error trace is created at `site`
+        virtual void OnErrorCreated(const ErrorTrace&, const TraceElement&) {}
+        
+        //`site` is appended to the error trace
+        virtual void OnTraceAppended(const ErrorTrace&, const TraceElement&) {}
+        
+        //A registered error is consumed by `DS_CHECK_PREV()` or `DS_CHECK_PREV_ACT()` at `site`
+        virtual void OnPrevChecked(const ErrorTrace&, const TraceElement&) {}
+        
+        //An error is passed to the thread local store by `DS_VALUE_OR()`. `site` is the last frame.
+        virtual void OnErrorProcessed(const ErrorTrace&, const TraceElement&) {}
+    };
+    
+    #if DS_USE_TRACE_HOOKS
+        inline std::atomic<TraceHooks*>& InternalTraceHooksSlot()
+        {
+            static std::atomic<TraceHooks*> hooks(nullptr);
+            return hooks;
+        }
+        
+        //Hooks must outlive any error activity. Pass nullptr to unregister.
+        inline void SetTraceHooks(TraceHooks* hooks)
+        {
+            InternalTraceHooksSlot().store(hooks, std::memory_order_release);
+        }
+        
+        #define INTERNAL_DS_HOOK(hookMethod, trace, site) \
+            do \
+            { \
+                DS::TraceHooks* dsHooks = \
+                    DS::InternalTraceHooksSlot().load(std::memory_order_acquire); \
+                if(dsHooks) \
+                    dsHooks->hookMethod(trace, site); \
+            } \
+            while(false)
+    #else
+        #define INTERNAL_DS_HOOK(hookMethod, trace, site) do {} while(false)
+    #endif
+    
+    //Probe arguments: file, line, function, error code
+    #if DS_USE_USDT
+        #define INTERNAL_DS_USDT(probeName, errorCode, site) \
+            DTRACE_PROBE4(dsresult, probeName, (site).File, (site).Line, (site).Function, errorCode)
+    #else
+        #define INTERNAL_DS_USDT(probeName, errorCode, site) do {} while(false)
+    #endif
+    
+    #define INTERNAL_DS_TRACE_EVENT(probeName, hookMethod, trace, site) \
+        do \
+        { \
+            INTERNAL_DS_USDT(probeName, (trace).ErrorCode, site); \
+            INTERNAL_DS_HOOK(hookMethod, trace, site); \
+        } \
+        while(false)
+    
+    //Appends the decimal digits of `value` to `out`, which can be any string type with 
+    //`append(const char*, std::size_t)`. Same text as `std::to_string()`.
+    template<typename S>
+    inline void InternalAppendUnsigned(S& out, unsigned long long value)
+    {
+        char digits[24];
+        int count = 0;
+        do
+        {
+            digits[sizeof(digits) - 1 - count++] = (char)('0' + value % 10);
+            value /= 10;
+        }
+        while(value != 0);
+        
+        out.append(digits + sizeof(digits) - count, (std::size_t)count);
+    }
+    
+    template<typename S>
+    inline void InternalAppendInt(S& out, long long value)
+    {
+        if(value < 0)
+        {
+            out.append("-", 1);
+            InternalAppendUnsigned(out, 0ULL - (unsigned long long)value);
+        }
+        else
+            InternalAppendUnsigned(out, (unsigned long long)value);
+    }
+    
+    //Small context payload attached to a trace frame, only formatted when the trace is rendered
+    struct TraceContext
+    {
+        enum class Kind : unsigned char
+        {
+            StaticString,
+            KeyValue,
+            CapturedString
+        };
+        
+        const char* Key;
+        long long Value;
+        int FrameIndex;
+        Kind ContextKind;
+        char Captured[DS_CONTEXT_INLINE_SIZE];
+        
+        //`str` must outlive the error trace, i.e. a string literal
+        static inline TraceContext Static(const char* str)
+        {
+            TraceContext context;
+            context.Key = str;
+            context.Value = 0;
+            context.FrameIndex = 0;
+            context.ContextKind = Kind::StaticString;
+            context.Captured[0] = '\0';
+            return context;
+        }
+        
+        //`key` must outlive the error trace, i.e. a string literal
+        static inline TraceContext KeyValue(const char* key, long long value)
+        {
+            TraceContext context = Static(key);
+            context.Value = value;
+            context.ContextKind = Kind::KeyValue;
+            return context;
+        }
+        
+        //Copies `str` into the inline buffer, truncated to `DS_CONTEXT_INLINE_SIZE - 1` characters
+        static inline TraceContext Capture(const char* key, const char* str, std::size_t length)
+        {
+            TraceContext context = Static(key);
+            context.ContextKind = Kind::CapturedString;
+            if(length > DS_CONTEXT_INLINE_SIZE - 1)
+                length = DS_CONTEXT_INLINE_SIZE - 1;
+            std::memcpy(context.Captured, str, length);
+            context.Captured[length] = '\0';
+            return context;
+        }
+        
+        static inline TraceContext Capture(const char* key, const char* str)
+        {
+            return Capture(key, str, std::strlen(str));
+        }
+        
+        static inline TraceContext Capture(const char* key, const std::string& str)
+        {
+            return Capture(key, str.data(), str.size());
+        }
+        
+        //`out` can be any string type with `append(const char*, std::size_t)`
+        template<typename S>
+        inline void AppendTo(S& out) const
+        {
+            out.append(Key, std::strlen(Key));
+            switch(ContextKind)
+            {
+                case Kind::StaticString:
+                    return;
+                case Kind::KeyValue:
+                    out.append(": ", 2);
+                    InternalAppendInt(out, Value);
+                    return;
+                case Kind::CapturedString:
+                default:
+                    out.append(": \"", 3);
+                    out.append(Captured, std::strlen(Captured));
+                    out.append("\"", 1);
+                    return;
+            }
+        }
+        
+        inline std::string ToString() const
+        {
+            std::string result;
+            AppendTo(result);
+            return result;
         }
     };
 
+    #if DS_USE_REALTIME_POOL
+        typedef DS::PoolString ErrorMessage;
+        typedef DS::PoolVector<TraceElement, DS_REALTIME_MAX_FRAMES> ErrorStack;
+        typedef DS::PoolVector<TraceContext, DS_REALTIME_MAX_CONTEXTS> ErrorContexts;
+
+        template<typename T, std::size_t N>
+        inline bool InternalTryPushBack(DS::PoolVector<T, N>& container, const T& value)
+        {
+            return container.TryPushBack(value);
+        }
+    #else
+        typedef std::string ErrorMessage;
+        typedef std::vector<TraceElement> ErrorStack;
+        typedef std::vector<TraceContext> ErrorContexts;
+
+        template<typename T>
+        inline bool InternalTryPushBack(std::vector<T>& container, const T& value)
+        {
+            container.push_back(value);
+            return true;
+        }
+    #endif
+
     struct ErrorTrace
     {
-        std::string Message;
-        std::vector<TraceElement> Stack;
+        ErrorMessage Message;
+        ErrorStack Stack;
         int ErrorCode;
+        ErrorContexts Contexts;
+        
+        //Number of frames that are dropped, which were before `Stack[OmittedIndex]`
+        int OmittedFrames;
+        int OmittedIndex;
+        
+        //When set, `ErrorCode` belongs to this category and its description is only resolved 
+        //when the error is rendered
+        const std::error_category* Category;
 
-        inline ErrorTrace() : Message(), Stack(), ErrorCode(0) {};
+        inline ErrorTrace() :   Message(), 
+                                Stack(), 
+                                ErrorCode(0), 
+                                Contexts(), 
+                                OmittedFrames(0), 
+                                OmittedIndex(0),
+                                Category(nullptr)
+        {};
 
         //Constructor for new error
-        inline ErrorTrace(const std::string& msg, const TraceElement& element) :    Message(msg),
-                                                                                    Stack(),
-                                                                                    ErrorCode(0)
+        inline ErrorTrace(  const std::string& msg, 
+                            const TraceElement& element,
+                            int errorCode = 0) :    Message(msg.data(), msg.size()),
+                                                    Stack(),
+                                                    ErrorCode(errorCode),
+                                                    Contexts(),
+                                                    OmittedFrames(0),
+                                                    OmittedIndex(0),
+                                                    Category(nullptr)
         {
-            Stack.emplace_back(element);
-            #if !defined(NDEBUG) && DS_USE_DEBUG_BREAK
-                debug_break();
-            #endif
+            InternalOnCreate(element);
         }
 
-        inline ErrorTrace(  const std::string& msg, 
+        inline ErrorTrace(  const char* msg, 
                             const TraceElement& element,
-                            int errorCode) :    Message(msg),
-                                                Stack(),
-                                                ErrorCode(errorCode)
+                            int errorCode = 0) :    Message(msg),
+                                                    Stack(),
+                                                    ErrorCode(errorCode),
+                                                    Contexts(),
+                                                    OmittedFrames(0),
+                                                    OmittedIndex(0),
+                                                    Category(nullptr)
         {
-            Stack.emplace_back(element);
-            #if !defined(NDEBUG) && DS_USE_DEBUG_BREAK
-                debug_break();
-            #endif
+            InternalOnCreate(element);
+        }
+
+        inline ErrorTrace(  ErrorMessage&& msg, 
+                            const TraceElement& element,
+                            int errorCode = 0) :    Message(std::move(msg)),
+                                                    Stack(),
+                                                    ErrorCode(errorCode),
+                                                    Contexts(),
+                                                    OmittedFrames(0),
+                                                    OmittedIndex(0),
+                                                    Category(nullptr)
+        {
+            InternalOnCreate(element);
+        }
+
+        //Constructor for an error code, `msg` is an optional prefix of the description
+        inline ErrorTrace(  const std::error_code& code, 
+                            const TraceElement& element,
+                            const char* msg = "") : Message(msg),
+                                                    Stack(),
+                                                    ErrorCode(code.value()),
+                                                    Contexts(),
+                                                    OmittedFrames(0),
+                                                    OmittedIndex(0),
+                                                    Category(&code.category())
+        {
+            InternalOnCreate(element);
         }
 
         inline ErrorTrace& operator=(const ErrorTrace& other)
         {
+            if(this == &other)
+                return *this;
+            
             Message = other.Message;
             Stack = other.Stack;
             ErrorCode = other.ErrorCode;
+            Contexts = other.Contexts;
+            OmittedFrames = other.OmittedFrames;
+            OmittedIndex = other.OmittedIndex;
+            Category = other.Category;
+            
+            //Frames that couldn't be copied
+            if(Stack.size() < other.Stack.size())
+                InternalTruncateFrom(other);
             return *this;
         }
 
-        inline ErrorTrace(const ErrorTrace& other)
+        inline ErrorTrace(const ErrorTrace& other) :    OmittedFrames(0), 
+                                                        OmittedIndex(0), 
+                                                        Category(nullptr)
         {
             *this = other;
         }
         
-        inline ErrorTrace& operator=(ErrorTrace&& other)
+        inline ErrorTrace& operator=(ErrorTrace&& other) noexcept
         {
             if(this != &other)
             {
                 Message = std::move(other.Message);
                 Stack = std::move(other.Stack);
                 ErrorCode = other.ErrorCode;
+                Contexts = std::move(other.Contexts);
+                OmittedFrames = other.OmittedFrames;
+                OmittedIndex = other.OmittedIndex;
+                Category = other.Category;
             }
             return *this;
         }
         
-        inline ErrorTrace(ErrorTrace&& other)
+        inline ErrorTrace(ErrorTrace&& other) noexcept :    OmittedFrames(0), 
+                                                            OmittedIndex(0), 
+                                                            Category(nullptr)
         {
-            *this = other;
+            *this = std::move(other);
+        }
+
+        inline void InternalOnCreate(const TraceElement& element)
+        {
+            #if !DS_USE_REALTIME_POOL
+                Stack.reserve(DS_TRACE_RESERVE_FRAMES);
+            #endif
+            InternalTryPushBack(Stack, element);
+            INTERNAL_DS_TRACE_EVENT(error_create, OnErrorCreated, *this, element);
+            #if !defined(NDEBUG) && DS_USE_DEBUG_BREAK
+                debug_break();
+            #endif
         }
 
+        //Called when only the first frames of `other` could be copied. Like `InternalOmitFrames()`,
+        //the head frames and the newest frames are kept, with the frames in between and the 
+        //frames already omitted by `other` counted in 1 gap.
+        inline void InternalTruncateFrom(const ErrorTrace& other)
+        {
+            const std::size_t size = Stack.size();
+            std::size_t head = size / 2 < DS_TRACE_HEAD_FRAMES ? size / 2 : DS_TRACE_HEAD_FRAMES;
+            if(head == 0)
+                head = size;
+            
+            //Moves the head so that the gap of `other` is inside the new gap
+            if(other.OmittedFrames > 0)
+            {
+                const std::size_t gap = (std::size_t)other.OmittedIndex;
+                const std::size_t afterGap = other.Stack.size() - gap;
+                if(gap < head)
+                    head = gap;
+                else if(afterGap < size - head)
+                    head = size - afterGap;
+            }
+            
+            const std::size_t tailStart = other.Stack.size() - (size - head);
+            for(std::size_t i = head; i < size; ++i)
+                Stack[i] = other.Stack[tailStart + i - head];
+            
+            OmittedFrames = other.OmittedFrames;
+            for(std::size_t i = head; i < tailStart; ++i)
+                OmittedFrames += other.Stack[i].Repeat;
+            OmittedIndex = (int)head;
+            
+            Contexts.clear();
+            for(std::size_t i = 0; i < other.Contexts.size(); ++i)
+            {
+                TraceContext context = other.Contexts[i];
+                if(context.FrameIndex >= (int)head && context.FrameIndex < (int)tailStart)
+                    continue;
+                if(context.FrameIndex >= (int)tailStart)
+                    context.FrameIndex -= (int)(tailStart - head);
+                if(!InternalTryPushBack(Contexts, context))
+                    break;
+            }
+        }
+        
+        //Drops the older half of the frames after the head frames, or after the frames that are 
+        //already omitted so that there's only 1 gap.
+        inline void InternalOmitFrames()
+        {
+            std::size_t head = Stack.size() / 2 < DS_TRACE_HEAD_FRAMES ? 
+                                Stack.size() / 2 : 
+                                DS_TRACE_HEAD_FRAMES;
+            if(OmittedFrames > 0)
+                head = (std::size_t)OmittedIndex;
+            else if(head == 0)
+                head = 1;
+            
+            if(head >= Stack.size())
+                return;
+            
+            const std::size_t count = (Stack.size() - head + 1) / 2;
+            const std::size_t end = head + count;
+            for(std::size_t i = head; i < end; ++i)
+                OmittedFrames += Stack[i].Repeat;
+            Stack.erase(Stack.begin() + head, Stack.begin() + end);
+            OmittedIndex = (int)head;
+            
+            std::size_t keptContexts = 0;
+            for(std::size_t i = 0; i < Contexts.size(); ++i)
+            {
+                TraceContext context = Contexts[i];
+                if(context.FrameIndex >= (int)head && context.FrameIndex < (int)end)
+                    continue;
+                if(context.FrameIndex >= (int)end)
+                    context.FrameIndex -= (int)count;
+                Contexts[keptContexts++] = context;
+            }
+            Contexts.erase(Contexts.begin() + keptContexts, Contexts.end());
+        }
+        
+        //With `DS_MERGE_REPEATED_FRAMES`, consecutive identical frames are merged by `Repeat`, 
+        //unless the last frame has contexts. The number of stored frames is bounded by 
+        //`DS_MAX_TRACE_DEPTH`.
         inline void AppendTrace(const TraceElement& element)
         {
-            Stack.push_back(element);
+            if( DS_MERGE_REPEATED_FRAMES &&
+                !Stack.empty() && 
+                Stack.back().SameSite(element) &&
+                (Contexts.empty() || Contexts.back().FrameIndex != (int)Stack.size() - 1))
+            {
+                ++Stack.back().Repeat;
+            }
+            else
+            {
+                bool stored = false;
+                #if DS_MAX_TRACE_DEPTH > 0
+                    if(Stack.size() >= (std::size_t)DS_MAX_TRACE_DEPTH)
+                        InternalOmitFrames();
+                    
+                    //Nothing could be dropped when the head frames fill the stack, for example 
+                    //with a depth of 1
+                    if(Stack.size() < (std::size_t)DS_MAX_TRACE_DEPTH)
+                #endif
+                {
+                    stored = InternalTryPushBack(Stack, element);
+                    if(!stored)
+                    {
+                        InternalOmitFrames();
+                        stored = InternalTryPushBack(Stack, element);
+                    }
+                }
+                
+                if(!stored)
+                {
+                    if(OmittedFrames == 0)
+                        OmittedIndex = (int)Stack.size();
+                    ++OmittedFrames;
+                }
+            }
+            INTERNAL_DS_TRACE_EVENT(error_append, OnTraceAppended, *this, element);
+        }
+        
+        //Attaches the context to the last frame in the stack
+        inline void AppendContext(const TraceContext& context)
+        {
+            #if !DS_USE_REALTIME_POOL
+                if(Contexts.size() == Contexts.capacity() && Contexts.capacity() < Stack.capacity())
+                    Contexts.reserve(Stack.capacity());
+            #endif
+            if(InternalTryPushBack(Contexts, context))
+                Contexts.back().FrameIndex = Stack.empty() ? 0 : (int)Stack.size() - 1;
         }
 
+        //Appends the message, followed by the description of `ErrorCode` if `Category` is set
+        inline void AppendMessageTo(std::string& out) const
+        {
+            out.append(Message.data(), Message.size());
+            if(Category == nullptr)
+                return;
+            
+            if(!Message.empty())
+                out += ": ";
+            out += Category->name();
+            out += ": ";
+            out += Category->message(ErrorCode);
+        }
+        
+        inline std::string GetMessage() const
+        {
+            std::string message;
+            AppendMessageTo(message);
+            return message;
+        }
+        
         inline operator std::string() const 
         {
-            std::string result =
-                "Error:\n  " + Message + 
-                (ErrorCode == 0 ? "" : "\nError Code: " + std::to_string(ErrorCode)) +
-                "\n\nStack trace:";
+            std::string result = "Error:\n  ";
+            AppendMessageTo(result);
+            if(ErrorCode != 0)
+                result += "\nError Code: " + std::to_string(ErrorCode);
+            result += "\n\nStack trace:";
+            
+            std::string omitted;
+            if(OmittedFrames > 0)
+                omitted = "\n  ... " + std::to_string(OmittedFrames) + " frames omitted";
+            
+            std::size_t contextIndex = 0;
+            for(int i = 0; i < (int)Stack.size(); ++i)
+            {
+                if(OmittedFrames > 0 && i == OmittedIndex)
+                    result += omitted;
+                result += "\n  at " + Stack[i].ToString();
+                while(contextIndex < Contexts.size() && Contexts[contextIndex].FrameIndex <= i)
+                {
+                    result.append("\n    - ", 7);
+                    Contexts[contextIndex++].AppendTo(result);
+                }
+            }
             
-            for(const TraceElement& trace : Stack)
-                result += "\n  at " + trace.ToString();
+            if(OmittedFrames > 0 && OmittedIndex >= (int)Stack.size())
+                result += omitted;
             return result;
         }
 
@@ -298,67 +846,652 @@ namespace DS
         return "";
     }
     
-    template<typename T>
-    struct Result : public DS_EXPECTED_TYPE<T, DS::ErrorTrace> 
+    //Returns the index of the first different byte, or `size` if they are equal
+    inline std::size_t InternalFindMismatch(const void* left, const void* right, std::size_t size)
     {
-        inline Result() : DS_EXPECTED_TYPE<T, DS::ErrorTrace>() {}
-        inline Result(const T& val) : DS_EXPECTED_TYPE<T, DS::ErrorTrace>(val) {}
-        
-        template<   typename Y, 
-                    typename std::enable_if<std::is_convertible<Y, T>::value, bool>::type = true>
-        inline Result(const Y& val) : DS_EXPECTED_TYPE<T, DS::ErrorTrace>(val) {}
-        
-        inline Result(const DS_EXPECTED_TYPE<T, DS::ErrorTrace>& ex) : 
-            DS_EXPECTED_TYPE<T, DS::ErrorTrace>(ex) {}
-        
-        template<   typename Y, 
-                    typename std::enable_if<std::is_convertible<Y, T>::value, bool>::type = true>
-        inline Result(const DS_EXPECTED_TYPE<Y, DS::ErrorTrace>& ex) : 
-            DS_EXPECTED_TYPE<T, DS::ErrorTrace>(ex) {}
+        const unsigned char* leftBytes = static_cast<const unsigned char*>(left);
+        const unsigned char* rightBytes = static_cast<const unsigned char*>(right);
+        std::size_t i = 0;
         
-        inline ~Result() {};
-        
-        using Base = DS_EXPECTED_TYPE<T, DS::ErrorTrace>;
-        
-        template<class F>
-        inline const Result<T>& CallIfFailed(F&& f) const &
-        {
-            if(!DS_EXPECTED_TYPE<T, DS::ErrorTrace>::has_value())
-                f(DS_EXPECTED_TYPE<T, DS::ErrorTrace>::error());
-            return *this;
-        }
+        #if INTERNAL_DS_USE_SSE2
+            //Skip equal 64 bytes blocks, then find the different byte 16 bytes at a time
+            for(; i + 64 <= size; i += 64)
+            {
+                __m128i equal = _mm_and_si128
+                (
+                    _mm_cmpeq_epi8( _mm_loadu_si128((const __m128i*)(leftBytes + i)),
+                                    _mm_loadu_si128((const __m128i*)(rightBytes + i))),
+                    _mm_cmpeq_epi8( _mm_loadu_si128((const __m128i*)(leftBytes + i + 16)),
+                                    _mm_loadu_si128((const __m128i*)(rightBytes + i + 16)))
+                );
+                equal = _mm_and_si128(equal, _mm_cmpeq_epi8
+                (
+                    _mm_loadu_si128((const __m128i*)(leftBytes + i + 32)),
+                    _mm_loadu_si128((const __m128i*)(rightBytes + i + 32))
+                ));
+                equal = _mm_and_si128(equal, _mm_cmpeq_epi8
+                (
+                    _mm_loadu_si128((const __m128i*)(leftBytes + i + 48)),
+                    _mm_loadu_si128((const __m128i*)(rightBytes + i + 48))
+                ));
+                if(_mm_movemask_epi8(equal) != 0xFFFF)
+                    break;
+            }
+            
+            for(; i + 16 <= size; i += 16)
+            {
+                const __m128i equal = 
+                    _mm_cmpeq_epi8( _mm_loadu_si128((const __m128i*)(leftBytes + i)),
+                                    _mm_loadu_si128((const __m128i*)(rightBytes + i)));
+                unsigned int different = (unsigned int)_mm_movemask_epi8(equal) ^ 0xFFFFu;
+                if(different != 0)
+                {
+                    while((different & 1u) == 0)
+                    {
+                        different >>= 1;
+                        ++i;
+                    }
+                    return i;
+                }
+            }
+        #endif
         
-        inline T DefaultOr() const&
+        for(; i + sizeof(std::uint64_t) <= size; i += sizeof(std::uint64_t))
         {
-            return DS_EXPECTED_TYPE<T, DS::ErrorTrace>::value_or(T());
+            std::uint64_t leftWord;
+            std::uint64_t rightWord;
+            std::memcpy(&leftWord, leftBytes + i, sizeof(leftWord));
+            std::memcpy(&rightWord, rightBytes + i, sizeof(rightWord));
+            if(leftWord != rightWord)
+                break;
         }
         
-        inline T DefaultOr() const &&
+        for(; i < size; ++i)
         {
-            return DS_EXPECTED_TYPE<T, DS::ErrorTrace>::value_or(T());
+            if(leftBytes[i] != rightBytes[i])
+                return i;
         }
+        return size;
+    }
+    
+    template<typename T>
+    struct InternalHasDataAndSize
+    {
+        template<typename U>
+        static decltype((void)std::declval<const U&>().data(), 
+                        (void)std::declval<const U&>().size(), 
+                        std::true_type()) Test(int);
         
-        inline bool HasValue() const
-        {
-            return DS_EXPECTED_TYPE<T, DS::ErrorTrace>::has_value();
-        }
+        template<typename U>
+        static std::false_type Test(...);
         
-        inline T& Value() &
-        {
-            return DS_EXPECTED_TYPE<T, DS::ErrorTrace>::value();
-        }
+        static constexpr bool Value = decltype(Test<T>(1))::value;
+    };
+    
+    template<typename T, std::size_t N>
+    inline const T* InternalRangeData(const T (&array)[N]) { return array; }
+    
+    template<typename T>
+    inline auto InternalRangeData(const T& range) -> decltype(range.data()) { return range.data(); }
+    
+    template<typename T>
+    inline std::size_t InternalRangeSize(const T& range)
+    {
+        return (std::size_t)std::distance(std::begin(range), std::end(range));
+    }
+    
+    template<typename T>
+    struct InternalRangeElement
+    {
+        using Type = typename std::remove_cv
+        <
+            typename std::remove_reference<decltype(*std::begin(std::declval<const T&>()))>::type
+        >::type;
+    };
+    
+    //Contiguous ranges of the same integer, enum or pointer type can be compared as bytes
+    template<typename L, typename R>
+    struct InternalBytewiseComparable
+    {
+        using Element = typename InternalRangeElement<L>::Type;
         
-        inline const T& Value() const&
-        {
-            return DS_EXPECTED_TYPE<T, DS::ErrorTrace>::value();
-        }
+        static constexpr bool LeftContiguous =  std::is_array<L>::value || 
+                                                InternalHasDataAndSize<L>::Value;
+        static constexpr bool RightContiguous = std::is_array<R>::value || 
+                                                InternalHasDataAndSize<R>::Value;
         
-        inline T&& Value() &&
+        static constexpr bool Value =   LeftContiguous && 
+                                        RightContiguous &&
+                                        std::is_same<   Element, 
+                                                        typename InternalRangeElement<R>::Type
+                                                    >::value &&
+                                        (std::is_integral<Element>::value || 
+                                        std::is_enum<Element>::value ||
+                                        std::is_pointer<Element>::value);
+    };
+    
+    template<typename L, typename R>
+    inline bool InternalRangeEqual( const L& left, 
+                                    const R& right, 
+                                    std::size_t& mismatch, 
+                                    std::true_type)
+    {
+        using Element = typename InternalRangeElement<L>::Type;
+        const std::size_t leftSize = InternalRangeSize(left);
+        const std::size_t rightSize = InternalRangeSize(right);
+        const std::size_t commonSize = leftSize < rightSize ? leftSize : rightSize;
+        mismatch = InternalFindMismatch(InternalRangeData(left), 
+                                        InternalRangeData(right), 
+                                        commonSize * sizeof(Element)) / sizeof(Element);
+        return mismatch == commonSize && leftSize == rightSize;
+    }
+    
+    template<typename L, typename R>
+    inline bool InternalRangeEqual( const L& left, 
+                                    const R& right, 
+                                    std::size_t& mismatch, 
+                                    std::false_type)
+    {
+        auto leftIt = std::begin(left);
+        auto rightIt = std::begin(right);
+        const auto leftEnd = std::end(left);
+        const auto rightEnd = std::end(right);
+        for(mismatch = 0; leftIt != leftEnd && rightIt != rightEnd; ++leftIt, ++rightIt, ++mismatch)
         {
-            return std::move(DS_EXPECTED_TYPE<T, DS::ErrorTrace>::value());
+            if(!(*leftIt == *rightIt))
+                return false;
         }
-        
-        inline const T&& Value() const &&
+        return leftIt == leftEnd && rightIt == rightEnd;
+    }
+    
+    //Sets `mismatch` to the index of the first different element, or the size of the shorter 
+    //range if one is a prefix of the other
+    template<typename L, typename R>
+    inline bool InternalRangeEqual(const L& left, const R& right, std::size_t& mismatch)
+    {
+        return InternalRangeEqual
+        (
+            left, 
+            right, 
+            mismatch, 
+            std::integral_constant<bool, InternalBytewiseComparable<L, R>::Value>()
+        );
+    }
+    
+    template<typename T>
+    struct InternalCanToString
+    {
+        static constexpr bool Value =   InternalNonStringPointer<T>::Value ||
+                                        InternalHasToString<T>::Value ||
+                                        InternalHasStringCtor<T>::Value ||
+                                        std::is_convertible<T, std::string>::value;
+    };
+    
+    //How `InternalAppendElement()` formats an element
+    enum class InternalElementKind
+    {
+        Pointer,
+        Signed,
+        Unsigned,
+        Floating,
+        CString,
+        String,
+        Other,
+        Unknown
+    };
+    
+    template<typename T>
+    struct InternalElementKindOf
+    {
+        static constexpr InternalElementKind Value = 
+            InternalNonStringPointer<T>::Value ? InternalElementKind::Pointer :
+            std::is_integral<T>::value && std::is_signed<T>::value ? InternalElementKind::Signed :
+            std::is_integral<T>::value ? InternalElementKind::Unsigned :
+            std::is_floating_point<T>::value ? InternalElementKind::Floating :
+            std::is_convertible<T, const char*>::value ? InternalElementKind::CString :
+            std::is_same<T, std::string>::value ? InternalElementKind::String :
+            InternalCanToString<T>::Value ? InternalElementKind::Other : 
+            InternalElementKind::Unknown;
+    };
+    
+    template<InternalElementKind K>
+    struct InternalElementTag {};
+    
+    template<typename S, typename T>
+    inline void InternalAppendElement(  S& out, 
+                                        const T& value, 
+                                        InternalElementTag<InternalElementKind::Pointer>)
+    {
+        InternalAppendUnsigned(out, (unsigned long long)(const void*)value);
+    }
+    
+    template<typename S, typename T>
+    inline void InternalAppendElement(  S& out, 
+                                        const T& value, 
+                                        InternalElementTag<InternalElementKind::Signed>)
+    {
+        InternalAppendInt(out, (long long)value);
+    }
+    
+    template<typename S, typename T>
+    inline void InternalAppendElement(  S& out, 
+                                        const T& value, 
+                                        InternalElementTag<InternalElementKind::Unsigned>)
+    {
+        InternalAppendUnsigned(out, (unsigned long long)value);
+    }
+    
+    //Same text as `std::to_string()`, truncated if it doesn't fit in the buffer
+    template<typename S, typename T>
+    inline void InternalAppendElement(  S& out, 
+                                        const T& value, 
+                                        InternalElementTag<InternalElementKind::Floating>)
+    {
+        char buffer[384];
+        int count = std::snprintf(buffer, sizeof(buffer), "%Lf", (long double)value);
+        if(count < 0)
+            return;
+        const std::size_t length = (std::size_t)count;
+        out.append(buffer, length < sizeof(buffer) ? length : sizeof(buffer) - 1);
+    }
+    
+    template<typename S, typename T>
+    inline void InternalAppendElement(  S& out, 
+                                        const T& value, 
+                                        InternalElementTag<InternalElementKind::CString>)
+    {
+        const char* str = value;
+        out.append(str, std::strlen(str));
+    }
+    
+    template<typename S, typename T>
+    inline void InternalAppendElement(  S& out, 
+                                        const T& value, 
+                                        InternalElementTag<InternalElementKind::String>)
+    {
+        out.append(value.data(), value.size());
+    }
+    
+    //Custom types are formatted by `DS::ToString()`, which can allocate
+    template<typename S, typename T>
+    inline void InternalAppendElement(  S& out, 
+                                        const T& value, 
+                                        InternalElementTag<InternalElementKind::Other>)
+    {
+        const std::string str = DS::ToString(value);
+        out.append(str.data(), str.size());
+    }
+    
+    template<typename S, typename T>
+    inline void InternalAppendElement(  S& out, 
+                                        const T&, 
+                                        InternalElementTag<InternalElementKind::Unknown>)
+    {
+        out.append("?", 1);
+    }
+    
+    //Appends `[first, last): a, b, [c], d` around `index`. `S` is `std::string` or `PoolString`.
+    template<typename S, typename T>
+    inline void InternalAppendRangeWindow(S& out, const T& range, std::size_t index)
+    {
+        typedef typename std::decay<decltype(*std::begin(range))>::type Element;
+        constexpr InternalElementKind Kind = InternalElementKindOf<Element>::Value;
+        const std::size_t size = InternalRangeSize(range);
+        const std::size_t first = index > DS_ASSERT_WINDOW ? index - DS_ASSERT_WINDOW : 0;
+        const std::size_t last =    size - index > DS_ASSERT_WINDOW ? 
+                                    index + DS_ASSERT_WINDOW + 1 : 
+                                    size;
+        
+        out.append("[", 1);
+        InternalAppendUnsigned(out, first);
+        out.append(", ", 2);
+        InternalAppendUnsigned(out, last);
+        out.append("):", 2);
+        if(first > 0)
+            out.append(" ...", 4);
+        
+        std::size_t i = 0;
+        for(auto it = std::begin(range); i < last; ++it, ++i)
+        {
+            if(i < first)
+                continue;
+            out.append(i == first ? " " : ", ", i == first ? 1 : 2);
+            if(i == index)
+                out.append("[", 1);
+            InternalAppendElement(out, *it, InternalElementTag<Kind>());
+            if(i == index)
+                out.append("]", 1);
+        }
+        
+        if(last < size)
+            out.append(", ...", 5);
+    }
+    
+    template<typename L, typename R>
+    inline DS::ErrorTrace InternalRangeError(   const L& left,
+                                                const R& right,
+                                                std::size_t mismatch,
+                                                const char* leftExpr,
+                                                const char* rightExpr,
+                                                const TraceElement& site,
+                                                int errorCode)
+    {
+        //Reserved once for the expressions and both windows of short elements. Built in the 
+        //message type directly, so nothing else is allocated for numbers and strings.
+        ErrorMessage msg;
+        msg.reserve(std::strlen(leftExpr) + std::strlen(rightExpr) + 256);
+        msg.append("Ranges \"");
+        msg.append(leftExpr);
+        msg.append("\" and \"");
+        msg.append(rightExpr);
+        msg.append("\" differ at index ");
+        InternalAppendUnsigned(msg, mismatch);
+        msg.append(" (sizes ");
+        InternalAppendUnsigned(msg, InternalRangeSize(left));
+        msg.append(" and ");
+        InternalAppendUnsigned(msg, InternalRangeSize(right));
+        msg.append(")\n  left  ");
+        InternalAppendRangeWindow(msg, left, mismatch);
+        msg.append("\n  right ");
+        InternalAppendRangeWindow(msg, right, mismatch);
+        return DS::ErrorTrace(std::move(msg), site, errorCode);
+    }
+    
+    //Appends `[first, last): 0a 0b [0c] 0d` around `index`
+    template<typename S>
+    inline void InternalAppendBytesWindow(  S& out, 
+                                            const unsigned char* bytes, 
+                                            std::size_t size, 
+                                            std::size_t index)
+    {
+        const char hex[] = "0123456789abcdef";
+        const std::size_t first = index > DS_ASSERT_WINDOW ? index - DS_ASSERT_WINDOW : 0;
+        const std::size_t last =    size - index > DS_ASSERT_WINDOW ? 
+                                    index + DS_ASSERT_WINDOW + 1 : 
+                                    size;
+        
+        out.append("[", 1);
+        InternalAppendUnsigned(out, first);
+        out.append(", ", 2);
+        InternalAppendUnsigned(out, last);
+        out.append("):", 2);
+        if(first > 0)
+            out.append(" ...", 4);
+        for(std::size_t i = first; i < last; ++i)
+        {
+            const char digits[] = { hex[bytes[i] >> 4], hex[bytes[i] & 0xF] };
+            out.append(i == index ? " [" : " ", i == index ? 2 : 1);
+            out.append(digits, 2);
+            if(i == index)
+                out.append("]", 1);
+        }
+        if(last < size)
+            out.append(" ...", 4);
+    }
+    
+    inline DS::ErrorTrace InternalBytesError(   const void* left,
+                                                const void* right,
+                                                std::size_t size,
+                                                std::size_t mismatch,
+                                                const char* leftExpr,
+                                                const char* rightExpr,
+                                                const TraceElement& site,
+                                                int errorCode)
+    {
+        ErrorMessage msg;
+        msg.reserve(std::strlen(leftExpr) + std::strlen(rightExpr) + 256);
+        msg.append("Bytes \"");
+        msg.append(leftExpr);
+        msg.append("\" and \"");
+        msg.append(rightExpr);
+        msg.append("\" differ at offset ");
+        InternalAppendUnsigned(msg, mismatch);
+        msg.append(" of ");
+        InternalAppendUnsigned(msg, size);
+        msg.append("\n  left  ");
+        InternalAppendBytesWindow(msg, static_cast<const unsigned char*>(left), size, mismatch);
+        msg.append("\n  right ");
+        InternalAppendBytesWindow(msg, static_cast<const unsigned char*>(right), size, mismatch);
+        return DS::ErrorTrace(std::move(msg), site, errorCode);
+    }
+    
+    template<typename T>
+    struct Result;
+    
+    template<typename T>
+    inline Result<T> InternalMakeErrorResult(DS::ErrorTrace&& et)
+    {
+        return Result<T>(DS_EXPECTED_TYPE<T, DS::ErrorTrace>
+        (
+            DS_UNEXPECTED_TYPE<DS::ErrorTrace>(std::move(et))
+        ));
+    }
+    
+    template<typename F, typename... Args>
+    struct InternalInvokeResult
+    {
+        using Type = typename std::decay<decltype(std::declval<F>()(std::declval<Args>()...))>::type;
+    };
+    
+    //Wraps the return value of a function into a result, including void
+    template<typename U>
+    struct InternalMapper
+    {
+        template<typename F, typename... Args>
+        static inline Result<U> Invoke(F&& f, Args&&... args)
+        {
+            return Result<U>(std::forward<F>(f)(std::forward<Args>(args)...));
+        }
+    };
+    
+    template<typename T>
+    struct Result : public DS_EXPECTED_TYPE<T, DS::ErrorTrace> 
+    {
+        inline Result() : DS_EXPECTED_TYPE<T, DS::ErrorTrace>() {}
+        inline Result(const T& val) : DS_EXPECTED_TYPE<T, DS::ErrorTrace>(val) {}
+        inline Result(T&& val) : DS_EXPECTED_TYPE<T, DS::ErrorTrace>(std::move(val)) {}
+        
+        template<   typename Y, 
+                    typename std::enable_if<std::is_convertible<Y, T>::value, bool>::type = true>
+        inline Result(const Y& val) : DS_EXPECTED_TYPE<T, DS::ErrorTrace>(val) {}
+        
+        inline Result(const DS_EXPECTED_TYPE<T, DS::ErrorTrace>& ex) : 
+            DS_EXPECTED_TYPE<T, DS::ErrorTrace>(ex) {}
+        
+        inline Result(DS_EXPECTED_TYPE<T, DS::ErrorTrace>&& ex) : 
+            DS_EXPECTED_TYPE<T, DS::ErrorTrace>(std::move(ex)) {}
+        
+        template<   typename Y, 
+                    typename std::enable_if<std::is_convertible<Y, T>::value, bool>::type = true>
+        inline Result(const DS_EXPECTED_TYPE<Y, DS::ErrorTrace>& ex) : 
+            DS_EXPECTED_TYPE<T, DS::ErrorTrace>(ex) {}
+        
+        inline Result(const Result& other) = default;
+        inline Result(Result&& other) = default;
+        inline Result& operator=(const Result& other) = default;
+        inline Result& operator=(Result&& other) = default;
+        
+        inline ~Result() {};
+        
+        using Base = DS_EXPECTED_TYPE<T, DS::ErrorTrace>;
+        using ValueType = T;
+        
+        template<class F>
+        inline const Result<T>& CallIfFailed(F&& f) const &
+        {
+            if(!DS_EXPECTED_TYPE<T, DS::ErrorTrace>::has_value())
+                f(DS_EXPECTED_TYPE<T, DS::ErrorTrace>::error());
+            return *this;
+        }
+        
+        //Returned by value, so that it doesn't dangle when called on a temporary
+        template<class F>
+        inline Result<T> CallIfFailed(F&& f) &&
+        {
+            if(!DS_EXPECTED_TYPE<T, DS::ErrorTrace>::has_value())
+                f(std::move(DS_EXPECTED_TYPE<T, DS::ErrorTrace>::error()));
+            return std::move(*this);
+        }
+        
+        //Used by `DS_VALUE_OR()`. Calls `f` with the error if failed, then returns the value or a 
+        //default constructed value without moving the result.
+        template<class F>
+        inline T InternalValueOr(F&& f) const &
+        {
+            if(!DS_EXPECTED_TYPE<T, DS::ErrorTrace>::has_value())
+            {
+                f(DS_EXPECTED_TYPE<T, DS::ErrorTrace>::error());
+                return T();
+            }
+            return DS_EXPECTED_TYPE<T, DS::ErrorTrace>::value();
+        }
+        
+        template<class F>
+        inline T InternalValueOr(F&& f) &&
+        {
+            if(!DS_EXPECTED_TYPE<T, DS::ErrorTrace>::has_value())
+            {
+                f(std::move(DS_EXPECTED_TYPE<T, DS::ErrorTrace>::error()));
+                return T();
+            }
+            return std::move(DS_EXPECTED_TYPE<T, DS::ErrorTrace>::value());
+        }
+        
+        //f(T) -> U, returns Result<U>. Appends `site` to the error if failed.
+        template<class F>
+        inline Result<typename InternalInvokeResult<F, T&&>::Type> 
+        Map(F&& f, const TraceElement& site) &&
+        {
+            using U = typename InternalInvokeResult<F, T&&>::Type;
+            if(!Base::has_value())
+            {
+                Error().AppendTrace(site);
+                return InternalMakeErrorResult<U>(std::move(Error()));
+            }
+            return InternalMapper<U>::Invoke(std::forward<F>(f), std::move(**this));
+        }
+        
+        template<class F>
+        inline Result<typename InternalInvokeResult<F, const T&>::Type> 
+        Map(F&& f, const TraceElement& site) const &
+        {
+            using U = typename InternalInvokeResult<F, const T&>::Type;
+            if(!Base::has_value())
+            {
+                DS::ErrorTrace et = Error();
+                et.AppendTrace(site);
+                return InternalMakeErrorResult<U>(std::move(et));
+            }
+            return InternalMapper<U>::Invoke(std::forward<F>(f), **this);
+        }
+        
+        //f(T) -> Result<U>, returns Result<U>. Appends `site` to the error if failed.
+        template<class F>
+        inline typename InternalInvokeResult<F, T&&>::Type 
+        AndThen(F&& f, const TraceElement& site) &&
+        {
+            using R = typename InternalInvokeResult<F, T&&>::Type;
+            if(!Base::has_value())
+            {
+                Error().AppendTrace(site);
+                return InternalMakeErrorResult<typename R::ValueType>(std::move(Error()));
+            }
+            return std::forward<F>(f)(std::move(**this));
+        }
+        
+        template<class F>
+        inline typename InternalInvokeResult<F, const T&>::Type 
+        AndThen(F&& f, const TraceElement& site) const &
+        {
+            using R = typename InternalInvokeResult<F, const T&>::Type;
+            if(!Base::has_value())
+            {
+                DS::ErrorTrace et = Error();
+                et.AppendTrace(site);
+                return InternalMakeErrorResult<typename R::ValueType>(std::move(et));
+            }
+            return std::forward<F>(f)(**this);
+        }
+        
+        //f(DS::ErrorTrace) -> Result<T>, called with `site` appended to the error if failed.
+        template<class F>
+        inline Result<T> OrElse(F&& f, const TraceElement& site) &&
+        {
+            if(Base::has_value())
+                return std::move(*this);
+            Error().AppendTrace(site);
+            return std::forward<F>(f)(std::move(Error()));
+        }
+        
+        template<class F>
+        inline Result<T> OrElse(F&& f, const TraceElement& site) const &
+        {
+            if(Base::has_value())
+                return *this;
+            DS::ErrorTrace et = Error();
+            et.AppendTrace(site);
+            return std::forward<F>(f)(std::move(et));
+        }
+        
+        //f(DS::ErrorTrace) -> DS::ErrorTrace, `site` is appended to the new error if failed.
+        template<class F>
+        inline Result<T> MapError(F&& f, const TraceElement& site) &&
+        {
+            if(Base::has_value())
+                return std::move(*this);
+            DS::ErrorTrace et = std::forward<F>(f)(std::move(Error()));
+            et.AppendTrace(site);
+            return InternalMakeErrorResult<T>(std::move(et));
+        }
+        
+        template<class F>
+        inline Result<T> MapError(F&& f, const TraceElement& site) const &
+        {
+            if(Base::has_value())
+                return *this;
+            DS::ErrorTrace et = std::forward<F>(f)(Error());
+            et.AppendTrace(site);
+            return InternalMakeErrorResult<T>(std::move(et));
+        }
+        
+        inline T DefaultOr() const&
+        {
+            return DS_EXPECTED_TYPE<T, DS::ErrorTrace>::value_or(T());
+        }
+        
+        inline T DefaultOr() const &&
+        {
+            return DS_EXPECTED_TYPE<T, DS::ErrorTrace>::value_or(T());
+        }
+        
+        inline T DefaultOr() &&
+        {
+            if(DS_EXPECTED_TYPE<T, DS::ErrorTrace>::has_value())
+                return std::move(DS_EXPECTED_TYPE<T, DS::ErrorTrace>::value());
+            return T();
+        }
+        
+        inline bool HasValue() const
+        {
+            return DS_EXPECTED_TYPE<T, DS::ErrorTrace>::has_value();
+        }
+        
+        inline T& Value() &
+        {
+            return DS_EXPECTED_TYPE<T, DS::ErrorTrace>::value();
+        }
+        
+        inline const T& Value() const&
+        {
+            return DS_EXPECTED_TYPE<T, DS::ErrorTrace>::value();
+        }
+        
+        inline T&& Value() &&
+        {
+            return std::move(DS_EXPECTED_TYPE<T, DS::ErrorTrace>::value());
+        }
+        
+        inline const T&& Value() const &&
         {
             return std::move(DS_EXPECTED_TYPE<T, DS::ErrorTrace>::value());
         }
@@ -391,9 +1524,18 @@ namespace DS
         inline Result(const DS_EXPECTED_TYPE<void, DS::ErrorTrace>& ex) : 
             DS_EXPECTED_TYPE<void, DS::ErrorTrace>(ex) {}
         
+        inline Result(DS_EXPECTED_TYPE<void, DS::ErrorTrace>&& ex) : 
+            DS_EXPECTED_TYPE<void, DS::ErrorTrace>(std::move(ex)) {}
+        
+        inline Result(const Result& other) = default;
+        inline Result(Result&& other) = default;
+        inline Result& operator=(const Result& other) = default;
+        inline Result& operator=(Result&& other) = default;
+        
         inline ~Result() {};
         
         using Base = DS_EXPECTED_TYPE<void, DS::ErrorTrace>;
+        using ValueType = void;
         
         template<class F>
         inline const Result<void>& CallIfFailed(F&& f) const &
@@ -403,8 +1545,130 @@ namespace DS
             return *this;
         }
         
+        //Returned by value, so that it doesn't dangle when called on a temporary
+        template<class F>
+        inline Result<void> CallIfFailed(F&& f) &&
+        {
+            if(!DS_EXPECTED_TYPE<void, DS::ErrorTrace>::has_value())
+                f(std::move(DS_EXPECTED_TYPE<void, DS::ErrorTrace>::error()));
+            return std::move(*this);
+        }
+        
+        //Used by `DS_VALUE_OR()`. Calls `f` with the error if failed.
+        template<class F>
+        inline void InternalValueOr(F&& f) const &
+        {
+            if(!DS_EXPECTED_TYPE<void, DS::ErrorTrace>::has_value())
+                f(DS_EXPECTED_TYPE<void, DS::ErrorTrace>::error());
+        }
+        
+        template<class F>
+        inline void InternalValueOr(F&& f) &&
+        {
+            if(!DS_EXPECTED_TYPE<void, DS::ErrorTrace>::has_value())
+                f(std::move(DS_EXPECTED_TYPE<void, DS::ErrorTrace>::error()));
+        }
+        
+        //f() -> U, returns Result<U>. Appends `site` to the error if failed.
+        template<class F>
+        inline Result<typename InternalInvokeResult<F>::Type> 
+        Map(F&& f, const TraceElement& site) const &
+        {
+            using U = typename InternalInvokeResult<F>::Type;
+            if(!Base::has_value())
+            {
+                DS::ErrorTrace et = Error();
+                et.AppendTrace(site);
+                return InternalMakeErrorResult<U>(std::move(et));
+            }
+            return InternalMapper<U>::Invoke(std::forward<F>(f));
+        }
+        
+        template<class F>
+        inline Result<typename InternalInvokeResult<F>::Type> 
+        Map(F&& f, const TraceElement& site) &&
+        {
+            using U = typename InternalInvokeResult<F>::Type;
+            if(!Base::has_value())
+            {
+                Error().AppendTrace(site);
+                return InternalMakeErrorResult<U>(std::move(Error()));
+            }
+            return InternalMapper<U>::Invoke(std::forward<F>(f));
+        }
+        
+        //f() -> Result<U>, returns Result<U>. Appends `site` to the error if failed.
+        template<class F>
+        inline typename InternalInvokeResult<F>::Type 
+        AndThen(F&& f, const TraceElement& site) const &
+        {
+            using R = typename InternalInvokeResult<F>::Type;
+            if(!Base::has_value())
+            {
+                DS::ErrorTrace et = Error();
+                et.AppendTrace(site);
+                return InternalMakeErrorResult<typename R::ValueType>(std::move(et));
+            }
+            return std::forward<F>(f)();
+        }
+        
+        template<class F>
+        inline typename InternalInvokeResult<F>::Type 
+        AndThen(F&& f, const TraceElement& site) &&
+        {
+            using R = typename InternalInvokeResult<F>::Type;
+            if(!Base::has_value())
+            {
+                Error().AppendTrace(site);
+                return InternalMakeErrorResult<typename R::ValueType>(std::move(Error()));
+            }
+            return std::forward<F>(f)();
+        }
+        
+        //f(DS::ErrorTrace) -> Result<void>, called with `site` appended to the error if failed.
+        template<class F>
+        inline Result<void> OrElse(F&& f, const TraceElement& site) &&
+        {
+            if(Base::has_value())
+                return std::move(*this);
+            Error().AppendTrace(site);
+            return std::forward<F>(f)(std::move(Error()));
+        }
+        
+        template<class F>
+        inline Result<void> OrElse(F&& f, const TraceElement& site) const &
+        {
+            if(Base::has_value())
+                return *this;
+            DS::ErrorTrace et = Error();
+            et.AppendTrace(site);
+            return std::forward<F>(f)(std::move(et));
+        }
+        
+        //f(DS::ErrorTrace) -> DS::ErrorTrace, `site` is appended to the new error if failed.
+        template<class F>
+        inline Result<void> MapError(F&& f, const TraceElement& site) &&
+        {
+            if(Base::has_value())
+                return std::move(*this);
+            DS::ErrorTrace et = std::forward<F>(f)(std::move(Error()));
+            et.AppendTrace(site);
+            return InternalMakeErrorResult<void>(std::move(et));
+        }
+        
+        template<class F>
+        inline Result<void> MapError(F&& f, const TraceElement& site) const &
+        {
+            if(Base::has_value())
+                return *this;
+            DS::ErrorTrace et = std::forward<F>(f)(Error());
+            et.AppendTrace(site);
+            return InternalMakeErrorResult<void>(std::move(et));
+        }
+        
         inline void DefaultOr() const&      { return; }
         inline void DefaultOr() const &&    { return; }
+        inline void DefaultOr() &&          { return; }
         inline bool HasValue() const
         {
             return DS_EXPECTED_TYPE<void, DS::ErrorTrace>::has_value();
@@ -433,16 +1697,369 @@ namespace DS
         }
     };
     
+    template<>
+    struct InternalMapper<void>
+    {
+        template<typename F, typename... Args>
+        static inline Result<void> Invoke(F&& f, Args&&... args)
+        {
+            std::forward<F>(f)(std::forward<Args>(args)...);
+            return Result<void>();
+        }
+    };
+    
     struct Error : public DS_UNEXPECTED_TYPE<DS::ErrorTrace>
     {
         Error(const DS::ErrorTrace& et) : DS_UNEXPECTED_TYPE<DS::ErrorTrace>(et) {}
+        Error(DS::ErrorTrace&& et) : DS_UNEXPECTED_TYPE<DS::ErrorTrace>(std::move(et)) {}
         Error(const Error& other) : DS_UNEXPECTED_TYPE<DS::ErrorTrace>(other) {}
+        Error(Error&& other) : 
+            DS_UNEXPECTED_TYPE<DS::ErrorTrace>
+            (
+                static_cast<DS_UNEXPECTED_TYPE<DS::ErrorTrace>&&>(other)
+            )
+        {}
         
         template< typename T >
-        operator Result<T>() const
+        operator Result<T>() const &
         {
             return DS_EXPECTED_TYPE<T, DS::ErrorTrace>(DS_UNEXPECTED_TYPE<DS::ErrorTrace>(*this));
         }
+        
+        template< typename T >
+        operator Result<T>() &&
+        {
+            return DS_EXPECTED_TYPE<T, DS::ErrorTrace>
+            (
+                static_cast<DS_UNEXPECTED_TYPE<DS::ErrorTrace>&&>(*this)
+            );
+        }
+    };
+    
+    //Literal type error for `DS::StaticResult`. `Message` must be a string literal.
+    struct StaticError
+    {
+        const char* Message;
+        TraceElement Site;
+        int ErrorCode;
+        
+        inline DS_CONSTEXPR StaticError(const char* msg, 
+                                        const TraceElement& site, 
+                                        int errorCode) :    Message(msg),
+                                                            Site(site),
+                                                            ErrorCode(errorCode)
+        {}
+        
+        inline DS::ErrorTrace ToErrorTrace() const
+        {
+            return DS::ErrorTrace(Message, Site, ErrorCode);
+        }
+    };
+    
+    //constexpr usable subset of `DS::Result` (since C++14), `T` must be a default constructible 
+    //literal type. Convert to `DS::Result` with `ToResult()` at runtime.
+    template<typename T>
+    struct StaticResult
+    {
+        T StoredValue;
+        StaticError StoredError;
+        bool Succeeded;
+        
+        inline DS_CONSTEXPR 
+        StaticResult(const T& val) :    StoredValue(val),
+                                        StoredError(nullptr, TraceElement(nullptr, nullptr, 0), 0),
+                                        Succeeded(true)
+        {}
+        
+        inline DS_CONSTEXPR 
+        StaticResult(const StaticError& error) :    StoredValue(),
+                                                    StoredError(error),
+                                                    Succeeded(false)
+        {}
+        
+        inline DS_CONSTEXPR bool HasValue() const { return Succeeded; }
+        inline DS_CONSTEXPR const T& Value() const { return StoredValue; }
+        inline DS_CONSTEXPR const StaticError& Error() const { return StoredError; }
+        
+        inline Result<T> ToResult() const
+        {
+            if(!Succeeded)
+                return InternalMakeErrorResult<T>(StoredError.ToErrorTrace());
+            return Result<T>(StoredValue);
+        }
+        
+        inline operator Result<T>() const
+        {
+            return ToResult();
+        }
+    };
+    
+    template<>
+    struct StaticResult<void>
+    {
+        StaticError StoredError;
+        bool Succeeded;
+        
+        inline DS_CONSTEXPR 
+        StaticResult() :    StoredError(nullptr, TraceElement(nullptr, nullptr, 0), 0),
+                            Succeeded(true)
+        {}
+        
+        inline DS_CONSTEXPR 
+        StaticResult(const StaticError& error) :    StoredError(error),
+                                                    Succeeded(false)
+        {}
+        
+        inline DS_CONSTEXPR bool HasValue() const { return Succeeded; }
+        inline DS_CONSTEXPR const StaticError& Error() const { return StoredError; }
+        
+        inline Result<void> ToResult() const
+        {
+            if(!Succeeded)
+                return InternalMakeErrorResult<void>(StoredError.ToErrorTrace());
+            return Result<void>();
+        }
+        
+        inline operator Result<void>() const
+        {
+            return ToResult();
+        }
+    };
+    
+    //Collects errors without returning early, for example to report every failing field of a 
+    //validation pass. Messages are stored back to back in one string, frames and contexts in one 
+    //vector each. Convert to a single error with `ToErrorTrace()` or `DS_CHECK_LIST()`.
+    struct ErrorList
+    {
+        struct Entry
+        {
+            std::size_t MessageOffset;
+            std::size_t MessageSize;
+            std::size_t FrameOffset;
+            std::size_t FrameCount;
+            std::size_t ContextOffset;
+            std::size_t ContextCount;
+            int ErrorCode;
+            
+            //Same as `ErrorTrace`, relative to the frames of the entry
+            int OmittedFrames;
+            int OmittedIndex;
+            const std::error_category* Category;
+            
+            //The message is the message of the error when `Category` isn't set. Otherwise it is
+            //followed by the category name and the description of `ErrorCode`, which ends it.
+            std::size_t TextSize;
+            std::size_t DescriptionSize;
+        };
+        
+        std::string Messages;
+        std::vector<TraceElement> Frames;
+        
+        //`FrameIndex` is relative to the frames of the entry
+        std::vector<TraceContext> Contexts;
+        std::vector<Entry> Entries;
+        
+        inline bool Empty() const { return Entries.empty(); }
+        inline std::size_t Size() const { return Entries.size(); }
+        
+        inline void Clear()
+        {
+            Messages.clear();
+            Frames.clear();
+            Contexts.clear();
+            Entries.clear();
+        }
+        
+        inline void InternalBeginEntry(int errorCode)
+        {
+            Entry entry;
+            entry.MessageOffset = Messages.size();
+            entry.MessageSize = 0;
+            entry.FrameOffset = Frames.size();
+            entry.FrameCount = 0;
+            entry.ContextOffset = Contexts.size();
+            entry.ContextCount = 0;
+            entry.ErrorCode = errorCode;
+            entry.OmittedFrames = 0;
+            entry.OmittedIndex = 0;
+            entry.Category = nullptr;
+            entry.TextSize = 0;
+            entry.DescriptionSize = 0;
+            Entries.push_back(entry);
+        }
+        
+        inline void InternalEndEntry()
+        {
+            Entry& entry = Entries.back();
+            entry.MessageSize = Messages.size() - entry.MessageOffset;
+            entry.TextSize = entry.MessageSize;
+            entry.FrameCount = Frames.size() - entry.FrameOffset;
+            entry.ContextCount = Contexts.size() - entry.ContextOffset;
+        }
+        
+        inline void Add(const char* msg, 
+                        std::size_t length, 
+                        const TraceElement& site, 
+                        int errorCode)
+        {
+            InternalBeginEntry(errorCode);
+            Messages.append(msg, length);
+            Frames.push_back(site);
+            InternalEndEntry();
+        }
+        
+        inline void Add(const char* msg, const TraceElement& site, int errorCode)
+        {
+            Add(msg, std::strlen(msg), site, errorCode);
+        }
+        
+        inline void Add(const std::string& msg, const TraceElement& site, int errorCode)
+        {
+            Add(msg.data(), msg.size(), site, errorCode);
+        }
+        
+        //Same message as `DS_ASSERT_*`, built directly in the arena
+        inline void AddAssert(  const std::string& left,
+                                const char* op,
+                                const std::string& right,
+                                const TraceElement& site,
+                                int errorCode)
+        {
+            InternalBeginEntry(errorCode);
+            Messages.append("Expression \"", 12);
+            Messages.append(left);
+            Messages.append(" ", 1);
+            Messages.append(op);
+            Messages.append(" ", 1);
+            Messages.append(right);
+            Messages.append("\" has failed.", 13);
+            Frames.push_back(site);
+            InternalEndEntry();
+        }
+        
+        //Adds an existing error, with `site` appended to its frames
+        inline void Add(const ErrorTrace& trace, const TraceElement& site)
+        {
+            InternalBeginEntry(trace.ErrorCode);
+            trace.AppendMessageTo(Messages);
+            Frames.insert(Frames.end(), trace.Stack.begin(), trace.Stack.end());
+            Frames.push_back(site);
+            Contexts.insert(Contexts.end(), trace.Contexts.begin(), trace.Contexts.end());
+            InternalEndEntry();
+            
+            Entry& entry = Entries.back();
+            entry.OmittedFrames = trace.OmittedFrames;
+            entry.OmittedIndex = trace.OmittedIndex;
+            entry.Category = trace.Category;
+            if(trace.Category != nullptr)
+            {
+                //`message: name: description`, see `ErrorTrace::AppendMessageTo()`
+                const std::size_t prefixSize =  trace.Message.size() + 
+                                                (trace.Message.empty() ? 0 : 2) +
+                                                std::strlen(trace.Category->name()) + 2;
+                entry.TextSize = trace.Message.size();
+                entry.DescriptionSize = entry.MessageSize - prefixSize;
+            }
+        }
+        
+        //The first non zero error code
+        inline int ErrorCode() const
+        {
+            for(std::size_t i = 0; i < Entries.size(); ++i)
+            {
+                if(Entries[i].ErrorCode != 0)
+                    return Entries[i].ErrorCode;
+            }
+            return 0;
+        }
+        
+        inline std::size_t InternalEstimatedSize() const
+        {
+            return 16 + Messages.size() + Entries.size() * 32 + Frames.size() * 64;
+        }
+        
+        //Renders all the errors in one pass into `out`, which can be any string type with 
+        //`append(const char*, std::size_t)`
+        template<typename S>
+        inline void Render(S& out) const
+        {
+            InternalAppendInt(out, (long long)Entries.size());
+            if(Entries.size() == 1)
+                out.append(" error:", 7);
+            else
+                out.append(" errors:", 8);
+            
+            for(std::size_t i = 0; i < Entries.size(); ++i)
+            {
+                const Entry& entry = Entries[i];
+                out.append("\n  [", 4);
+                InternalAppendInt(out, (long long)i + 1);
+                out.append("] ", 2);
+                out.append(Messages.data() + entry.MessageOffset, entry.MessageSize);
+                
+                if(entry.ErrorCode != 0)
+                {
+                    out.append("\n      Error Code: ", 19);
+                    InternalAppendInt(out, entry.ErrorCode);
+                }
+                
+                std::size_t contextIndex = entry.ContextOffset;
+                const std::size_t contextEnd = entry.ContextOffset + entry.ContextCount;
+                for(std::size_t j = 0; j < entry.FrameCount; ++j)
+                {
+                    if(entry.OmittedFrames > 0 && (int)j == entry.OmittedIndex)
+                        InternalAppendOmitted(out, entry.OmittedFrames);
+                    
+                    const TraceElement& frame = Frames[entry.FrameOffset + j];
+                    out.append("\n      at ", 10);
+                    out.append(frame.File, std::strlen(frame.File));
+                    out.append(":", 1);
+                    InternalAppendInt(out, frame.Line);
+                    out.append(" in ", 4);
+                    out.append(frame.Function, std::strlen(frame.Function));
+                    out.append("()", 2);
+                    if(frame.Repeat > 1)
+                    {
+                        out.append(" x ", 3);
+                        InternalAppendInt(out, frame.Repeat);
+                    }
+                    
+                    while(contextIndex < contextEnd && Contexts[contextIndex].FrameIndex <= (int)j)
+                    {
+                        out.append("\n        - ", 11);
+                        Contexts[contextIndex++].AppendTo(out);
+                    }
+                }
+                
+                if(entry.OmittedFrames > 0 && entry.OmittedIndex >= (int)entry.FrameCount)
+                    InternalAppendOmitted(out, entry.OmittedFrames);
+            }
+        }
+        
+        template<typename S>
+        static inline void InternalAppendOmitted(S& out, int omittedFrames)
+        {
+            out.append("\n      ... ", 11);
+            InternalAppendInt(out, omittedFrames);
+            out.append(" frames omitted", 15);
+        }
+        
+        inline std::string ToString() const
+        {
+            std::string result;
+            result.reserve(InternalEstimatedSize());
+            Render(result);
+            return result;
+        }
+        
+        //Creates a single error with all the collected errors as its message
+        inline DS::ErrorTrace ToErrorTrace(const TraceElement& site) const
+        {
+            ErrorMessage msg;
+            msg.reserve(InternalEstimatedSize());
+            Render(msg);
+            return DS::ErrorTrace(std::move(msg), site, ErrorCode());
+        }
     };
 }
 
@@ -463,12 +2080,96 @@ namespace DS
         
         inline void ProcessError(DS::ErrorTrace et) 
         {
+            if(!et.Stack.empty())
+                INTERNAL_DS_TRACE_EVENT(process_error, OnErrorProcessed, et, et.Stack.back());
+            
             if(InlinerV::GlobalErrorTrace.Stack.empty())
-                InlinerV::GlobalErrorTrace = et;
+                InlinerV::GlobalErrorTrace = std::move(et);
             return;
         }
     }
 
+    //Builds the assert message in place, which avoids the temporaries of string concatenation
+    inline DS::ErrorTrace InternalAssertError(  const std::string& left,
+                                                const char* op,
+                                                const std::string& right,
+                                                const TraceElement& site,
+                                                int errorCode)
+    {
+        const std::size_t opLength = std::strlen(op);
+        ErrorMessage msg;
+        msg.reserve(12 + left.size() + 1 + opLength + 1 + right.size() + 13);
+        msg.append("Expression \"", 12);
+        msg.append(left.data(), left.size());
+        msg.append(" ", 1);
+        msg.append(op, opLength);
+        msg.append(" ", 1);
+        msg.append(right.data(), right.size());
+        msg.append("\" has failed.", 13);
+        return DS::ErrorTrace(std::move(msg), site, errorCode);
+    }
+    
+    //A function returning `DS::Result` is not wrapped again
+    template<typename R>
+    struct InternalCatchInvoker
+    {
+        using Type = Result<R>;
+        
+        template<typename F>
+        static inline Type Invoke(F&& f)
+        {
+            return InternalMapper<R>::Invoke(std::forward<F>(f));
+        }
+    };
+    
+    template<typename U>
+    struct InternalCatchInvoker<Result<U>>
+    {
+        using Type = Result<U>;
+        
+        template<typename F>
+        static inline Type Invoke(F&& f)
+        {
+            return std::forward<F>(f)();
+        }
+    };
+    
+    //Calls `f` and converts an escaping exception into an error. `std::system_error` keeps its 
+    //error code and category, other exceptions copy their `what()`.
+    template<typename F>
+    inline typename InternalCatchInvoker<typename InternalInvokeResult<F>::Type>::Type 
+    Catch(F&& f, const TraceElement& site)
+    {
+        using Invoker = InternalCatchInvoker<typename InternalInvokeResult<F>::Type>;
+        
+        #if INTERNAL_DS_HAS_EXCEPTIONS
+            using U = typename Invoker::Type::ValueType;
+            try
+            {
+                return Invoker::Invoke(std::forward<F>(f));
+            }
+            catch(const std::system_error& e)
+            {
+                return InternalMakeErrorResult<U>(DS::ErrorTrace(e.code(), site));
+            }
+            catch(const std::bad_alloc&)
+            {
+                return InternalMakeErrorResult<U>(DS::ErrorTrace("Out of memory", site));
+            }
+            catch(const std::exception& e)
+            {
+                return InternalMakeErrorResult<U>(DS::ErrorTrace(e.what(), site));
+            }
+            catch(...)
+            {
+                return InternalMakeErrorResult<U>(DS::ErrorTrace("Unknown exception", site));
+            }
+        #else
+            (void)site;
+            return Invoker::Invoke(std::forward<F>(f));
+        #endif
+    }
+
     #define DS_ERROR_MSG(msg) \
         DS::Error(DS::ErrorTrace(msg, DS::TraceElement(__func__, DSGetFileName(DS_PATH), __LINE__)))
     
@@ -477,21 +2178,67 @@ namespace DS
                                     DS::TraceElement(__func__, DSGetFileName(DS_PATH), __LINE__), \
                                     (int)errorCode))
     
+    #define INTERNAL_DS_SITE() DS::TraceElement(__func__, DSGetFileName(DS_PATH), __LINE__)
+    
+    #define DS_ERROR_CODE(errorCode) DS::Error(DS::ErrorTrace(errorCode, INTERNAL_DS_SITE()))
+    #define DS_ERROR_CODE_MSG(errorCode, staticStr) \
+        DS::Error(DS::ErrorTrace(errorCode, INTERNAL_DS_SITE(), staticStr))
+    
+    #define DS_ERROR_ERRNO() \
+        DS::Error(DS::ErrorTrace(   std::error_code(errno, std::generic_category()), \
+                                    INTERNAL_DS_SITE()))
+    #define DS_ERROR_ERRNO_MSG(staticStr) \
+        DS::Error(DS::ErrorTrace(   std::error_code(errno, std::generic_category()), \
+                                    INTERNAL_DS_SITE(), \
+                                    staticStr))
+    
+    //Returns an error with `errno` if `op` is false, i.e. `DS_CHECK_ERRNO(close(fd) == 0)`
+    #define DS_CHECK_ERRNO(op) \
+        do \
+        { \
+            if(!(op)) \
+                return DS_ERROR_ERRNO(); \
+        } \
+        while(false)
+    
+    //Returns an error with `errorCode` (`std::error_code`) if it is set
+    #define DS_CHECK_ERROR_CODE(errorCode) \
+        do \
+        { \
+            const std::error_code& INTERNAL_DS_TEMP_NANE(dsErrorCode) = errorCode; \
+            if(INTERNAL_DS_TEMP_NANE(dsErrorCode)) \
+                return DS_ERROR_CODE(INTERNAL_DS_TEMP_NANE(dsErrorCode)); \
+        } \
+        while(false)
+    
+    #define DS_CATCH(...) DS::Catch(__VA_ARGS__, INTERNAL_DS_SITE())
+    
     #define DS_STR(nonStr) DS::ToString(nonStr)
     #define DS_APPEND_TRACE(prev) \
         (prev.AppendTrace(DS::TraceElement(__func__, DSGetFileName(DS_PATH), __LINE__)), prev)
     
+    #define DS_CTX(staticStr) DS::TraceContext::Static(staticStr)
+    #define DS_CTX_KV(key, value) DS::TraceContext::KeyValue(key, (long long)(value))
+    #define DS_CTX_CAPTURE(key, str) DS::TraceContext::Capture(key, str)
+    
+    #define DS_APPEND_TRACE_CTX(prev, context) \
+        (   prev.AppendTrace(DS::TraceElement(__func__, DSGetFileName(DS_PATH), __LINE__)), \
+            prev.AppendContext(context), \
+            prev)
+    
     #define INTERNAL_DS_ASSERT(left, op, right) \
         do \
         { \
-            auto INTERNAL_DS_TEMP_NANE(autoLeft) = left; \
-            auto INTERNAL_DS_TEMP_NANE(autoRight) = right; \
+            const auto& INTERNAL_DS_TEMP_NANE(autoLeft) = left; \
+            const auto& INTERNAL_DS_TEMP_NANE(autoRight) = right; \
             if(!(INTERNAL_DS_TEMP_NANE(autoLeft) op INTERNAL_DS_TEMP_NANE(autoRight))) \
             { \
-                return DS_ERROR_MSG(std::string("Expression \"") + \
-                                    DS_STR(INTERNAL_DS_TEMP_NANE(autoLeft)) + \
-                                    " " + #op + " " + \
-                                    DS_STR(INTERNAL_DS_TEMP_NANE(autoRight)) + "\" has failed."); \
+                return DS::Error( \
+                    DS::InternalAssertError(DS_STR(INTERNAL_DS_TEMP_NANE(autoLeft)), \
+                                            #op, \
+                                            DS_STR(INTERNAL_DS_TEMP_NANE(autoRight)), \
+                                            INTERNAL_DS_SITE(), \
+                                            0)); \
             } \
         } \
         while(false)
@@ -499,15 +2246,122 @@ namespace DS
     #define INTERNAL_DS_ASSERT_EC(left, op, right, errorCode) \
         do \
         { \
-            auto INTERNAL_DS_TEMP_NANE(autoLeft) = left; \
-            auto INTERNAL_DS_TEMP_NANE(autoRight) = right; \
+            const auto& INTERNAL_DS_TEMP_NANE(autoLeft) = left; \
+            const auto& INTERNAL_DS_TEMP_NANE(autoRight) = right; \
             if(!(INTERNAL_DS_TEMP_NANE(autoLeft) op INTERNAL_DS_TEMP_NANE(autoRight))) \
             { \
-                return DS_ERROR_MSG_EC( std::string("Expression \"") + \
-                                        DS_STR(INTERNAL_DS_TEMP_NANE(autoLeft)) + \
-                                        " " + #op + " " + \
-                                        DS_STR(INTERNAL_DS_TEMP_NANE(autoRight)) + "\" has failed.", \
-                                        errorCode); \
+                return DS::Error( \
+                    DS::InternalAssertError(DS_STR(INTERNAL_DS_TEMP_NANE(autoLeft)), \
+                                            #op, \
+                                            DS_STR(INTERNAL_DS_TEMP_NANE(autoRight)), \
+                                            INTERNAL_DS_SITE(), \
+                                            (int)errorCode)); \
+            } \
+        } \
+        while(false)
+    
+    #define INTERNAL_DS_COLLECT_ASSERT(list, left, op, right, errorCode) \
+        do \
+        { \
+            const auto& INTERNAL_DS_TEMP_NANE(autoLeft) = left; \
+            const auto& INTERNAL_DS_TEMP_NANE(autoRight) = right; \
+            if(!(INTERNAL_DS_TEMP_NANE(autoLeft) op INTERNAL_DS_TEMP_NANE(autoRight))) \
+            { \
+                (list).AddAssert(   DS_STR(INTERNAL_DS_TEMP_NANE(autoLeft)), \
+                                    #op, \
+                                    DS_STR(INTERNAL_DS_TEMP_NANE(autoRight)), \
+                                    INTERNAL_DS_SITE(), \
+                                    (int)errorCode); \
+            } \
+        } \
+        while(false)
+    
+    #define INTERNAL_DS_ASSERT_RANGE(left, right, errorCode) \
+        do \
+        { \
+            const auto& INTERNAL_DS_TEMP_NANE(rangeLeft) = left; \
+            const auto& INTERNAL_DS_TEMP_NANE(rangeRight) = right; \
+            std::size_t INTERNAL_DS_TEMP_NANE(mismatch) = 0; \
+            if(!DS::InternalRangeEqual( INTERNAL_DS_TEMP_NANE(rangeLeft), \
+                                        INTERNAL_DS_TEMP_NANE(rangeRight), \
+                                        INTERNAL_DS_TEMP_NANE(mismatch))) \
+            { \
+                return DS::Error(DS::InternalRangeError(INTERNAL_DS_TEMP_NANE(rangeLeft), \
+                                                        INTERNAL_DS_TEMP_NANE(rangeRight), \
+                                                        INTERNAL_DS_TEMP_NANE(mismatch), \
+                                                        #left, \
+                                                        #right, \
+                                                        INTERNAL_DS_SITE(), \
+                                                        (int)errorCode)); \
+            } \
+        } \
+        while(false)
+    
+    #define INTERNAL_DS_ASSERT_BYTES(left, right, size, errorCode) \
+        do \
+        { \
+            const void* INTERNAL_DS_TEMP_NANE(bytesLeft) = left; \
+            const void* INTERNAL_DS_TEMP_NANE(bytesRight) = right; \
+            const std::size_t INTERNAL_DS_TEMP_NANE(bytesSize) = size; \
+            const std::size_t INTERNAL_DS_TEMP_NANE(mismatch) = \
+                DS::InternalFindMismatch(   INTERNAL_DS_TEMP_NANE(bytesLeft), \
+                                            INTERNAL_DS_TEMP_NANE(bytesRight), \
+                                            INTERNAL_DS_TEMP_NANE(bytesSize)); \
+            if(INTERNAL_DS_TEMP_NANE(mismatch) != INTERNAL_DS_TEMP_NANE(bytesSize)) \
+            { \
+                return DS::Error(DS::InternalBytesError(INTERNAL_DS_TEMP_NANE(bytesLeft), \
+                                                        INTERNAL_DS_TEMP_NANE(bytesRight), \
+                                                        INTERNAL_DS_TEMP_NANE(bytesSize), \
+                                                        INTERNAL_DS_TEMP_NANE(mismatch), \
+                                                        #left, \
+                                                        #right, \
+                                                        INTERNAL_DS_SITE(), \
+                                                        (int)errorCode)); \
+            } \
+        } \
+        while(false)
+    
+    #define DS_COLLECT_MSG(list, msg) (list).Add(msg, INTERNAL_DS_SITE(), 0)
+    #define DS_COLLECT_MSG_EC(list, msg, errorCode) \
+        (list).Add(msg, INTERNAL_DS_SITE(), (int)errorCode)
+    
+    #define DS_COLLECT_CHECK(list, op) \
+        do \
+        { \
+            auto&& INTERNAL_DS_TEMP_NANE(dsResult) = op; \
+            if(!INTERNAL_DS_TEMP_NANE(dsResult).has_value()) \
+                (list).Add(INTERNAL_DS_TEMP_NANE(dsResult).error(), INTERNAL_DS_SITE()); \
+        } \
+        while(false)
+    
+    #define DS_CHECK_LIST(list) \
+        do \
+        { \
+            if(!(list).Empty()) \
+                return DS::Error((list).ToErrorTrace(INTERNAL_DS_SITE())); \
+        } \
+        while(false)
+    
+    #define DS_STATIC_ERROR_MSG(msg) DS::StaticError(msg, INTERNAL_DS_SITE(), 0)
+    #define DS_STATIC_ERROR_MSG_EC(msg, errorCode) \
+        DS::StaticError(msg, INTERNAL_DS_SITE(), (int)errorCode)
+    
+    #define DS_STATIC_CHECK(resultVar) \
+        do \
+        { \
+            if(!resultVar.HasValue()) \
+                return resultVar.Error(); \
+        } \
+        while(false)
+    
+    #define INTERNAL_DS_STATIC_ASSERT(left, op, right, errorCode) \
+        do \
+        { \
+            if(!((left) op (right))) \
+            { \
+                return DS_STATIC_ERROR_MSG_EC(  "Expression \"" #left " " #op " " #right \
+                                                "\" has failed.", \
+                                                errorCode); \
             } \
         } \
         while(false)
@@ -534,7 +2388,7 @@ namespace DS
     #define DS_UNWRAP_RETURN(unwrapVar, op) \
         auto INTERNAL_DS_TEMP_NANE(dsResult) = op; \
         DS_CHECKED_RETURN(INTERNAL_DS_TEMP_NANE(dsResult)); \
-        unwrapVar = INTERNAL_DS_TEMP_NANE(dsResult).value()
+        unwrapVar = std::move(INTERNAL_DS_TEMP_NANE(dsResult).value())
     
     //NOTE: Legacy, don't use
     #define DS_ASSERT_RETURN(op) \
@@ -544,6 +2398,14 @@ namespace DS
                 return DS::Error(DS_ERROR_MSG("Expression \"" #op "\" has failed.")); \
         } \
         while(false)
+    
+    #define DS_CHECKED_RETURN_CTX(resultVar, context) \
+        do \
+        { \
+            if(!resultVar.has_value()) \
+                return DS::Error(std::move(DS_APPEND_TRACE_CTX(resultVar.error(), context))); \
+        } \
+        while(false)
 
     #define DS_TMP_ERROR dsTempResultRef.error()
     #define DS_CHECK(resultVar) DS_CHECKED_RETURN(resultVar)
@@ -566,6 +2428,28 @@ namespace DS
         } \
         while(false)
     
+    #define DS_CHECK_CTX(resultVar, context) DS_CHECKED_RETURN_CTX(resultVar, context)
+    
+    #define DS_UNWRAP_VOID_CTX(op, context) \
+        do \
+        { \
+            auto INTERNAL_DS_TEMP_NANE(dsResult) = op; \
+            DS_CHECKED_RETURN_CTX(INTERNAL_DS_TEMP_NANE(dsResult), context); \
+        } \
+        while(false)
+    
+    #define DS_UNWRAP_DECL_CTX(unwrapVar, op, context) \
+        auto INTERNAL_DS_TEMP_NANE(dsResult) = op; \
+        DS_CHECKED_RETURN_CTX(INTERNAL_DS_TEMP_NANE(dsResult), context); \
+        unwrapVar = std::move(INTERNAL_DS_TEMP_NANE(dsResult).value())
+    
+    #define DS_UNWRAP_ASSIGN_CTX(unwrapVar, op, context) \
+        do \
+        { \
+            DS_UNWRAP_DECL_CTX(unwrapVar, op, context); \
+        } \
+        while(false)
+    
     #define DS_UNWRAP_VOID_ACT(op, failedActions) \
         do \
         { \
@@ -585,7 +2469,7 @@ namespace DS
         { \
             failedActions; \
         } \
-        unwrapVar = INTERNAL_DS_TEMP_NANE(dsResult).value()
+        unwrapVar = std::move(INTERNAL_DS_TEMP_NANE(dsResult).value())
     
     #define DS_UNWRAP_ASSIGN_ACT(unwrapVar, op, failedActions) \
         do \
@@ -596,17 +2480,21 @@ namespace DS
             { \
                 failedActions; \
             } \
-            unwrapVar = INTERNAL_DS_TEMP_NANE(dsResult).value(); \
+            unwrapVar = std::move(INTERNAL_DS_TEMP_NANE(dsResult).value()); \
         } \
         while(false)
     
-    #define DS_VALUE_OR() CallIfFailed(DS::ProcessError).DefaultOr()
+    #define DS_VALUE_OR() InternalValueOr(DS::ProcessError)
     
     #define DS_CHECK_PREV() \
         do \
         { \
             if(!DS::InlinerV::GlobalErrorTrace.Stack.empty()) \
             { \
+                INTERNAL_DS_TRACE_EVENT(check_prev, \
+                                        OnPrevChecked, \
+                                        DS::InlinerV::GlobalErrorTrace, \
+                                        DS::TraceElement(__func__, DSGetFileName(DS_PATH), __LINE__)); \
                 DS::ErrorTrace returnErrorTrace = std::move(DS::InlinerV::GlobalErrorTrace); \
                 DS::InlinerV::GlobalErrorTrace = DS::ErrorTrace(); \
                 return DS::Error(std::move(DS_APPEND_TRACE(returnErrorTrace))); \
@@ -618,6 +2506,10 @@ namespace DS
         { \
             if(!DS::InlinerV::GlobalErrorTrace.Stack.empty()) \
             { \
+                INTERNAL_DS_TRACE_EVENT(check_prev, \
+                                        OnPrevChecked, \
+                                        DS::InlinerV::GlobalErrorTrace, \
+                                        DS::TraceElement(__func__, DSGetFileName(DS_PATH), __LINE__)); \
                 DS::Result<void> returnErr = DS::Error(std::move(DS::InlinerV::GlobalErrorTrace)); \
                 DS::InlinerV::GlobalErrorTrace = DS::ErrorTrace(); \
                 DS::Result<void>& dsTempResultRef = returnErr; (void)dsTempResultRef; \
@@ -629,6 +2521,11 @@ namespace DS
 
     #define DS_TRY_ACT(failedActions) DS_VALUE_OR(); DS_CHECK_PREV_ACT(failedActions)
 
+    #define DS_MAP(...) Map(__VA_ARGS__, INTERNAL_DS_SITE())
+    #define DS_AND_THEN(...) AndThen(__VA_ARGS__, INTERNAL_DS_SITE())
+    #define DS_OR_ELSE(...) OrElse(__VA_ARGS__, INTERNAL_DS_SITE())
+    #define DS_MAP_ERROR(...) MapError(__VA_ARGS__, INTERNAL_DS_SITE())
+    
     #define DS_ASSERT_TRUE(op) INTERNAL_DS_ASSERT(op, ==, true)
     #define DS_ASSERT_FALSE(op) INTERNAL_DS_ASSERT(op, ==, false)
     #define DS_ASSERT_EQ(op, val) INTERNAL_DS_ASSERT(op, ==, val)
@@ -647,6 +2544,66 @@ namespace DS
     #define DS_ASSERT_LT_EC(op, val, errorCode) INTERNAL_DS_ASSERT_EC(op, <, val, errorCode)
     #define DS_ASSERT_LT_EQ_EC(op, val, errorCode) INTERNAL_DS_ASSERT_EC(op, <=, val, errorCode)
     
+    #define DS_STATIC_ASSERT_TRUE(op) INTERNAL_DS_STATIC_ASSERT(op, ==, true, 0)
+    #define DS_STATIC_ASSERT_FALSE(op) INTERNAL_DS_STATIC_ASSERT(op, ==, false, 0)
+    #define DS_STATIC_ASSERT_EQ(op, val) INTERNAL_DS_STATIC_ASSERT(op, ==, val, 0)
+    #define DS_STATIC_ASSERT_NOT_EQ(op, val) INTERNAL_DS_STATIC_ASSERT(op, !=, val, 0)
+    #define DS_STATIC_ASSERT_GT(op, val) INTERNAL_DS_STATIC_ASSERT(op, >, val, 0)
+    #define DS_STATIC_ASSERT_GT_EQ(op, val) INTERNAL_DS_STATIC_ASSERT(op, >=, val, 0)
+    #define DS_STATIC_ASSERT_LT(op, val) INTERNAL_DS_STATIC_ASSERT(op, <, val, 0)
+    #define DS_STATIC_ASSERT_LT_EQ(op, val) INTERNAL_DS_STATIC_ASSERT(op, <=, val, 0)
+    
+    #define DS_STATIC_ASSERT_TRUE_EC(op, errorCode) \
+        INTERNAL_DS_STATIC_ASSERT(op, ==, true, errorCode)
+    #define DS_STATIC_ASSERT_FALSE_EC(op, errorCode) \
+        INTERNAL_DS_STATIC_ASSERT(op, ==, false, errorCode)
+    #define DS_STATIC_ASSERT_EQ_EC(op, val, errorCode) \
+        INTERNAL_DS_STATIC_ASSERT(op, ==, val, errorCode)
+    #define DS_STATIC_ASSERT_NOT_EQ_EC(op, val, errorCode) \
+        INTERNAL_DS_STATIC_ASSERT(op, !=, val, errorCode)
+    #define DS_STATIC_ASSERT_GT_EC(op, val, errorCode) \
+        INTERNAL_DS_STATIC_ASSERT(op, >, val, errorCode)
+    #define DS_STATIC_ASSERT_GT_EQ_EC(op, val, errorCode) \
+        INTERNAL_DS_STATIC_ASSERT(op, >=, val, errorCode)
+    #define DS_STATIC_ASSERT_LT_EC(op, val, errorCode) \
+        INTERNAL_DS_STATIC_ASSERT(op, <, val, errorCode)
+    #define DS_STATIC_ASSERT_LT_EQ_EC(op, val, errorCode) \
+        INTERNAL_DS_STATIC_ASSERT(op, <=, val, errorCode)
+    
+    
+    #define DS_ASSERT_RANGE_EQ(left, right) INTERNAL_DS_ASSERT_RANGE(left, right, 0)
+    #define DS_ASSERT_BYTES_EQ(left, right, size) INTERNAL_DS_ASSERT_BYTES(left, right, size, 0)
+    #define DS_ASSERT_RANGE_EQ_EC(left, right, errorCode) \
+        INTERNAL_DS_ASSERT_RANGE(left, right, errorCode)
+    #define DS_ASSERT_BYTES_EQ_EC(left, right, size, errorCode) \
+        INTERNAL_DS_ASSERT_BYTES(left, right, size, errorCode)
+    
+    #define DS_COLLECT_ASSERT_TRUE(list, op) INTERNAL_DS_COLLECT_ASSERT(list, op, ==, true, 0)
+    #define DS_COLLECT_ASSERT_FALSE(list, op) INTERNAL_DS_COLLECT_ASSERT(list, op, ==, false, 0)
+    #define DS_COLLECT_ASSERT_EQ(list, op, val) INTERNAL_DS_COLLECT_ASSERT(list, op, ==, val, 0)
+    #define DS_COLLECT_ASSERT_NOT_EQ(list, op, val) INTERNAL_DS_COLLECT_ASSERT(list, op, !=, val, 0)
+    #define DS_COLLECT_ASSERT_GT(list, op, val) INTERNAL_DS_COLLECT_ASSERT(list, op, >, val, 0)
+    #define DS_COLLECT_ASSERT_GT_EQ(list, op, val) INTERNAL_DS_COLLECT_ASSERT(list, op, >=, val, 0)
+    #define DS_COLLECT_ASSERT_LT(list, op, val) INTERNAL_DS_COLLECT_ASSERT(list, op, <, val, 0)
+    #define DS_COLLECT_ASSERT_LT_EQ(list, op, val) INTERNAL_DS_COLLECT_ASSERT(list, op, <=, val, 0)
+    
+    #define DS_COLLECT_ASSERT_TRUE_EC(list, op, errorCode) \
+        INTERNAL_DS_COLLECT_ASSERT(list, op, ==, true, errorCode)
+    #define DS_COLLECT_ASSERT_FALSE_EC(list, op, errorCode) \
+        INTERNAL_DS_COLLECT_ASSERT(list, op, ==, false, errorCode)
+    #define DS_COLLECT_ASSERT_EQ_EC(list, op, val, errorCode) \
+        INTERNAL_DS_COLLECT_ASSERT(list, op, ==, val, errorCode)
+    #define DS_COLLECT_ASSERT_NOT_EQ_EC(list, op, val, errorCode) \
+        INTERNAL_DS_COLLECT_ASSERT(list, op, !=, val, errorCode)
+    #define DS_COLLECT_ASSERT_GT_EC(list, op, val, errorCode) \
+        INTERNAL_DS_COLLECT_ASSERT(list, op, >, val, errorCode)
+    #define DS_COLLECT_ASSERT_GT_EQ_EC(list, op, val, errorCode) \
+        INTERNAL_DS_COLLECT_ASSERT(list, op, >=, val, errorCode)
+    #define DS_COLLECT_ASSERT_LT_EC(list, op, val, errorCode) \
+        INTERNAL_DS_COLLECT_ASSERT(list, op, <, val, errorCode)
+    #define DS_COLLECT_ASSERT_LT_EQ_EC(list, op, val, errorCode) \
+        INTERNAL_DS_COLLECT_ASSERT(list, op, <=, val, errorCode)
+    
     
 }
 
@@ -0,0 +1,613 @@
+#ifndef DS_RESULT_NATIVE_EXPECTED_HPP
+#define DS_RESULT_NATIVE_EXPECTED_HPP
+
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if DS_USE_REALTIME_POOL
+    #include "RealtimePool.hpp"
+#endif
+
+#ifndef INTERNAL_DS_HAS_EXCEPTIONS
+    #if !defined(DS_NO_EXCEPTIONS) && \
+        (defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND))
+        #define INTERNAL_DS_HAS_EXCEPTIONS 1
+    #else
+        #define INTERNAL_DS_HAS_EXCEPTIONS 0
+    #endif
+#endif
+
+namespace DS
+{
+    struct NativeBadExpectedAccess : public std::exception
+    {
+        inline const char* what() const noexcept override
+        {
+            return "DS::NativeExpected has no value";
+        }
+    };
+
+    [[noreturn]] inline void InternalNativeBadAccess()
+    {
+        #if INTERNAL_DS_HAS_EXCEPTIONS
+            throw NativeBadExpectedAccess();
+        #else
+            std::abort();
+        #endif
+    }
+
+    //Storage of the error of `NativeExpected`. The error is only allocated when one is created,
+    //so the expected is just the value and a pointer.
+    //
+    //In real-time mode, the blocks come from the error pool of the thread and the error is kept in
+    //the scratch error of the thread if the pool is exhausted. Otherwise, each thread keeps the 
+    //last few freed blocks, which are reused when the error is moved into the result of the caller.
+    template<typename E>
+    struct InternalNativeBox
+    {
+        #if DS_USE_REALTIME_POOL
+            static_assert(  alignof(E) <= ErrorPool::HeaderSize,
+                            "E is over aligned for the error pool");
+
+            //Null if the thread has no pool or it is exhausted
+            static inline void* Allocate()
+            {
+                return ErrorPool::Allocate(sizeof(E));
+            }
+
+            static inline void Free(void* block)
+            {
+                ErrorPool::Free(block);
+            }
+
+            //The last error of the thread that couldn't be boxed, so that it can still be 
+            //propagated (truncated) by the results without a box. It is shared by every result of
+            //the thread that points to `Failed()`, replaced by the next error that can't be boxed 
+            //and never destroyed.
+            static inline E& Scratch()
+            {
+                alignas(E) static thread_local unsigned char storage[sizeof(E)];
+                static thread_local bool constructed = false;
+
+                if(!constructed)
+                {
+                    ::new(static_cast<void*>(&storage)) E();
+                    constructed = true;
+                }
+                return *reinterpret_cast<E*>(&storage);
+            }
+
+            //Error of the expected whose box couldn't be allocated, which stands for `Scratch()`. 
+            //It is never dereferenced.
+            static inline E* Failed()
+            {
+                alignas(E) static const unsigned char failed = 0;
+                return const_cast<E*>(reinterpret_cast<const E*>(&failed));
+            }
+        #else
+            //Propagating an error creates the box of the caller while the box of the callee is
+            //still alive, so a few blocks are kept
+            static const int CacheSize = 4;
+
+            struct Cache
+            {
+                void* Blocks[CacheSize];
+                int Count;
+
+                inline void Clear()
+                {
+                    for(int i = 0; i < Count; ++i)
+                        ::operator delete(Blocks[i]);
+                    Count = 0;
+                }
+
+                inline ~Cache()
+                {
+                    Clear();
+                }
+            };
+
+            static inline Cache& ThreadCache()
+            {
+                static thread_local Cache cache = { {}, 0 };
+                return cache;
+            }
+
+            static inline void* Allocate()
+            {
+                Cache& cache = ThreadCache();
+                if(cache.Count == 0)
+                    return ::operator new(sizeof(E));
+                return cache.Blocks[--cache.Count];
+            }
+
+            //Frees the blocks kept by the current thread
+            static inline void ClearThreadCache()
+            {
+                ThreadCache().Clear();
+            }
+
+            static inline void Free(void* block)
+            {
+                Cache& cache = ThreadCache();
+                if(cache.Count < CacheSize)
+                    cache.Blocks[cache.Count++] = block;
+                else
+                    ::operator delete(block);
+            }
+        #endif
+
+        //Shared error of the expected that are moved from, so that they stay an error without a 
+        //box. It is never modified, see `Mutable()`.
+        static inline E* Empty()
+        {
+            static const E empty;
+            return const_cast<E*>(&empty);
+        }
+
+        template<typename... Args>
+        static inline E* Create(Args&&... args)
+        {
+            void* block = Allocate();
+            #if DS_USE_REALTIME_POOL
+                if(block == nullptr)
+                {
+                    Scratch() = E(std::forward<Args>(args)...);
+                    return Failed();
+                }
+            #endif
+
+            #if INTERNAL_DS_HAS_EXCEPTIONS
+                try
+                {
+                    return ::new(block) E(std::forward<Args>(args)...);
+                }
+                catch(...)
+                {
+                    Free(block);
+                    throw;
+                }
+            #else
+                return ::new(block) E(std::forward<Args>(args)...);
+            #endif
+        }
+
+        //Whether `error` is `Empty()` or `Failed()` rather than a box
+        static inline bool IsShared(const E* error)
+        {
+            #if DS_USE_REALTIME_POOL
+                if(error == Failed())
+                    return true;
+            #endif
+            return error == Empty();
+        }
+
+        //The error that `error` stands for
+        static inline E& Get(E* error)
+        {
+            #if DS_USE_REALTIME_POOL
+                if(error == Failed())
+                    return Scratch();
+            #endif
+            return *error;
+        }
+
+        static inline E* Copy(E* error)
+        {
+            return IsShared(error) ? error : Create(*error);
+        }
+
+        //The error to modify, a box is created first if `error` is the shared empty error. In 
+        //real-time mode, `error` becomes `Failed()` if the box can't be allocated.
+        static inline E& Mutable(E*& error)
+        {
+            if(error != Empty())
+                return Get(error);
+
+            #if DS_USE_REALTIME_POOL
+                void* block = Allocate();
+                if(block == nullptr)
+                {
+                    error = Failed();
+                    Scratch() = E();
+                    return Scratch();
+                }
+                error = ::new(block) E();
+            #else
+                error = Create();
+            #endif
+            return *error;
+        }
+
+        static inline void Destroy(E* error)
+        {
+            if(IsShared(error))
+                return;
+            error->~E();
+            Free(error);
+        }
+    };
+
+    template<typename E>
+    class NativeUnexpected
+    {
+        public:
+            inline explicit NativeUnexpected(const E& error) : Error(error) {}
+            inline explicit NativeUnexpected(E&& error) : Error(std::move(error)) {}
+
+            inline E& error() & { return Error; }
+            inline const E& error() const & { return Error; }
+            inline E&& error() && { return std::move(Error); }
+            inline const E&& error() const && { return std::move(Error); }
+
+        private:
+            E Error;
+    };
+
+    //Copy, move and destruction of `InternalNativeStorage`
+    template<typename T, typename E>
+    struct InternalNativeOperations
+    {
+        using Box = InternalNativeBox<E>;
+
+        template<typename S>
+        static inline void CopyConstruct(S& storage, const S& other)
+        {
+            if(other.Error == nullptr)
+                ::new(static_cast<void*>(&storage.Value)) T(other.Value);
+            else
+                storage.Error = Box::Copy(other.Error);
+        }
+
+        template<typename S>
+        static inline void MoveConstruct(S& storage, S& other)
+            noexcept(std::is_nothrow_move_constructible<T>::value)
+        {
+            if(other.Error == nullptr)
+                ::new(static_cast<void*>(&storage.Value)) T(std::move(other.Value));
+            else
+            {
+                storage.Error = other.Error;
+                other.Error = Box::Empty();
+            }
+        }
+
+        template<typename S>
+        static inline void Destroy(S& storage) noexcept
+        {
+            if(storage.Error == nullptr)
+                storage.Value.~T();
+            else
+                Box::Destroy(storage.Error);
+        }
+
+        template<typename S>
+        static inline void CopyAssign(S& storage, const S& other)
+        {
+            if(&storage == &other)
+                return;
+
+            if(storage.Error == nullptr && other.Error == nullptr)
+                storage.Value = other.Value;
+            else if(storage.Error != nullptr && other.Error != nullptr)
+            {
+                E* error = Box::Copy(other.Error);
+                Box::Destroy(storage.Error);
+                storage.Error = error;
+            }
+            else if(other.Error == nullptr)
+            {
+                ::new(static_cast<void*>(&storage.Value)) T(other.Value);
+                Box::Destroy(storage.Error);
+                storage.Error = nullptr;
+            }
+            else
+            {
+                E* error = Box::Copy(other.Error);
+                storage.Value.~T();
+                storage.Error = error;
+            }
+        }
+
+        template<typename S>
+        static inline void MoveAssign(S& storage, S& other)
+            noexcept(std::is_nothrow_move_constructible<T>::value &&
+                     std::is_nothrow_move_assignable<T>::value)
+        {
+            if(&storage == &other)
+                return;
+
+            if(storage.Error == nullptr && other.Error == nullptr)
+                storage.Value = std::move(other.Value);
+            else
+            {
+                //Left as an error if moving the value throws
+                Destroy(storage);
+                storage.Error = Box::Empty();
+                if(other.Error == nullptr)
+                {
+                    ::new(static_cast<void*>(&storage.Value)) T(std::move(other.Value));
+                    storage.Error = nullptr;
+                }
+                else
+                {
+                    storage.Error = other.Error;
+                    other.Error = Box::Empty();
+                }
+            }
+        }
+    };
+
+    //The value and the error pointer, which is null when there's a value
+    template<typename T, typename E>
+    struct InternalNativeStorage
+    {
+        using Operations = InternalNativeOperations<T, E>;
+
+        union
+        {
+            T Value;
+        };
+        E* Error;
+
+        inline InternalNativeStorage() noexcept : Error(nullptr) {}
+
+        inline InternalNativeStorage(const InternalNativeStorage& other) : Error(nullptr)
+        {
+            Operations::CopyConstruct(*this, other);
+        }
+
+        inline InternalNativeStorage(InternalNativeStorage&& other)
+            noexcept(std::is_nothrow_move_constructible<T>::value) : Error(nullptr)
+        {
+            Operations::MoveConstruct(*this, other);
+        }
+
+        inline InternalNativeStorage& operator=(const InternalNativeStorage& other)
+        {
+            Operations::CopyAssign(*this, other);
+            return *this;
+        }
+
+        inline InternalNativeStorage& operator=(InternalNativeStorage&& other)
+            noexcept(noexcept(Operations::MoveAssign(other, other)))
+        {
+            Operations::MoveAssign(*this, other);
+            return *this;
+        }
+
+        inline ~InternalNativeStorage()
+        {
+            Operations::Destroy(*this);
+        }
+    };
+
+    template<typename T, typename E>
+    class NativeExpected;
+
+    template<typename T>
+    struct InternalIsNativeExpected : std::false_type {};
+
+    template<typename T, typename E>
+    struct InternalIsNativeExpected<NativeExpected<T, E>> : std::true_type {};
+
+    template<typename T>
+    struct InternalIsNativeUnexpected : std::false_type {};
+
+    template<typename E>
+    struct InternalIsNativeUnexpected<NativeUnexpected<E>> : std::true_type {};
+
+    //Expected container with the error allocated out of line. A null error pointer means there's
+    //a value, so no separate flag is needed and `sizeof(NativeExpected<int, E>)` is 2 pointers.
+    template<typename T, typename E>
+    class NativeExpected : private InternalNativeStorage<T, E>
+    {
+        template<typename, typename>
+        friend class NativeExpected;
+
+        using Storage = InternalNativeStorage<T, E>;
+        using Box = InternalNativeBox<E>;
+
+        public:
+            using value_type = T;
+            using error_type = E;
+            using unexpected_type = NativeUnexpected<E>;
+
+            inline NativeExpected() : Storage()
+            {
+                ::new(static_cast<void*>(&this->Value)) T();
+            }
+
+            template<   typename U = T,
+                        typename std::enable_if
+                        <
+                            std::is_constructible<T, U&&>::value &&
+                            !InternalIsNativeExpected<typename std::decay<U>::type>::value &&
+                            !InternalIsNativeUnexpected<typename std::decay<U>::type>::value,
+                            bool
+                        >::type = true>
+            inline NativeExpected(U&& value) : Storage()
+            {
+                ::new(static_cast<void*>(&this->Value)) T(std::forward<U>(value));
+            }
+
+            template<   typename U,
+                        typename std::enable_if<std::is_constructible<T, const U&>::value &&
+                                                !std::is_same<T, U>::value, bool>::type = true>
+            inline NativeExpected(const NativeExpected<U, E>& other) : Storage()
+            {
+                if(other.has_value())
+                    ::new(static_cast<void*>(&this->Value)) T(other.Value);
+                else
+                    this->Error = Box::Copy(other.Error);
+            }
+
+            template<typename G>
+            inline NativeExpected(const NativeUnexpected<G>& unexpected) : Storage()
+            {
+                this->Error = Box::Create(unexpected.error());
+            }
+
+            template<typename G>
+            inline NativeExpected(NativeUnexpected<G>&& unexpected) : Storage()
+            {
+                this->Error = Box::Create(std::move(unexpected.error()));
+            }
+
+            inline NativeExpected(const NativeExpected& other) = default;
+            inline NativeExpected(NativeExpected&& other) = default;
+            inline NativeExpected& operator=(const NativeExpected& other) = default;
+            inline NativeExpected& operator=(NativeExpected&& other) = default;
+
+            inline bool has_value() const noexcept { return this->Error == nullptr; }
+            inline explicit operator bool() const noexcept { return has_value(); }
+
+            inline T& value() &
+            {
+                if(!has_value())
+                    InternalNativeBadAccess();
+                return this->Value;
+            }
+
+            inline const T& value() const &
+            {
+                if(!has_value())
+                    InternalNativeBadAccess();
+                return this->Value;
+            }
+
+            inline T&& value() &&
+            {
+                if(!has_value())
+                    InternalNativeBadAccess();
+                return std::move(this->Value);
+            }
+
+            inline const T&& value() const &&
+            {
+                if(!has_value())
+                    InternalNativeBadAccess();
+                return std::move(this->Value);
+            }
+
+            template<typename U>
+            inline T value_or(U&& defaultValue) const &
+            {
+                return has_value() ? this->Value : static_cast<T>(std::forward<U>(defaultValue));
+            }
+
+            template<typename U>
+            inline T value_or(U&& defaultValue) &&
+            {
+                return has_value() ?
+                       std::move(this->Value) :
+                       static_cast<T>(std::forward<U>(defaultValue));
+            }
+
+            inline T& operator*() & noexcept { return this->Value; }
+            inline const T& operator*() const & noexcept { return this->Value; }
+            inline T&& operator*() && noexcept { return std::move(this->Value); }
+            inline const T&& operator*() const && noexcept { return std::move(this->Value); }
+            inline T* operator->() noexcept { return &this->Value; }
+            inline const T* operator->() const noexcept { return &this->Value; }
+
+            inline E& error() & { return Box::Mutable(this->Error); }
+            inline const E& error() const & noexcept { return Box::Get(this->Error); }
+            inline E&& error() && { return std::move(Box::Mutable(this->Error)); }
+            inline const E&& error() const && noexcept { return std::move(Box::Get(this->Error)); }
+    };
+
+    //Only the error pointer
+    template<typename E>
+    class NativeExpected<void, E>
+    {
+        using Box = InternalNativeBox<E>;
+
+        public:
+            using value_type = void;
+            using error_type = E;
+            using unexpected_type = NativeUnexpected<E>;
+
+            inline NativeExpected() noexcept : Error(nullptr) {}
+
+            template<typename G>
+            inline NativeExpected(const NativeUnexpected<G>& unexpected) :
+                Error(Box::Create(unexpected.error()))
+            {}
+
+            template<typename G>
+            inline NativeExpected(NativeUnexpected<G>&& unexpected) :
+                Error(Box::Create(std::move(unexpected.error())))
+            {}
+
+            inline NativeExpected(const NativeExpected& other) :
+                Error(other.Error == nullptr ? nullptr : Box::Copy(other.Error))
+            {}
+
+            inline NativeExpected(NativeExpected&& other) noexcept : Error(other.Error)
+            {
+                if(other.Error != nullptr)
+                    other.Error = Box::Empty();
+            }
+
+            inline NativeExpected& operator=(const NativeExpected& other)
+            {
+                if(this != &other)
+                {
+                    E* error = other.Error == nullptr ? nullptr : Box::Copy(other.Error);
+                    Reset();
+                    Error = error;
+                }
+                return *this;
+            }
+
+            inline NativeExpected& operator=(NativeExpected&& other) noexcept
+            {
+                if(this != &other)
+                {
+                    Reset();
+                    Error = other.Error;
+                    if(other.Error != nullptr)
+                        other.Error = Box::Empty();
+                }
+                return *this;
+            }
+
+            inline ~NativeExpected()
+            {
+                Reset();
+            }
+
+            inline bool has_value() const noexcept { return Error == nullptr; }
+            inline explicit operator bool() const noexcept { return has_value(); }
+
+            inline void value() const
+            {
+                if(!has_value())
+                    InternalNativeBadAccess();
+            }
+
+            inline void operator*() const noexcept {}
+
+            inline E& error() & { return Box::Mutable(Error); }
+            inline const E& error() const & noexcept { return Box::Get(Error); }
+            inline E&& error() && { return std::move(Box::Mutable(Error)); }
+            inline const E&& error() const && noexcept { return std::move(Box::Get(Error)); }
+
+        private:
+            E* Error;
+
+            inline void Reset() noexcept
+            {
+                if(Error != nullptr)
+                    Box::Destroy(Error);
+                Error = nullptr;
+            }
+    };
+}
+
+#endif
@@ -0,0 +1,581 @@
+#ifndef DS_RESULT_REALTIME_POOL_HPP
+#define DS_RESULT_REALTIME_POOL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <string>
+#include <type_traits>
+
+//When enabled, a thread without a reserved pool reserves one of `DS_REALTIME_DEFAULT_POOL_SIZE` 
+//bytes on its first error, which calls the system allocator on the error path. Otherwise, errors
+//on such threads are truncated.
+#ifndef DS_REALTIME_LAZY_RESERVE
+    #define DS_REALTIME_LAZY_RESERVE 0
+#endif
+
+#ifndef DS_REALTIME_DEFAULT_POOL_SIZE
+    #define DS_REALTIME_DEFAULT_POOL_SIZE 65536
+#endif
+
+//Maximum number of characters stored for an error message, longer messages are truncated
+#ifndef DS_REALTIME_MESSAGE_CAPACITY
+    #define DS_REALTIME_MESSAGE_CAPACITY 256
+#endif
+
+//Maximum number of frames stored for an error trace, further frames are counted as omitted
+#ifndef DS_REALTIME_MAX_FRAMES
+    #define DS_REALTIME_MAX_FRAMES 64
+#endif
+
+//Maximum number of contexts stored for an error trace, further contexts are dropped
+#ifndef DS_REALTIME_MAX_CONTEXTS
+    #define DS_REALTIME_MAX_CONTEXTS 16
+#endif
+
+namespace DS
+{
+    //Fixed size arena owned by a thread, handing out power of 2 sized blocks (64 bytes to 128KB).
+    //Every operation is O(1): popping a free list, swapping in the blocks freed by other threads
+    //with a single atomic exchange, or bumping the arena. Blocks freed by other threads are pushed
+    //with a lock-free compare and swap. Freeing a block never deletes the pool, a pool with blocks
+    //still allocated when its thread releases it is kept in an orphan list and deleted by a later
+    //`CollectOrphans()` once all its blocks are freed.
+    struct ErrorPool
+    {
+        static const int ClassCount = 12;
+        static const std::size_t MinBlockSize = 64;
+        static const std::size_t HeaderSize = 16;
+
+        struct FreeBlock
+        {
+            FreeBlock* Next;
+        };
+
+        struct BlockHeader
+        {
+            ErrorPool* Owner;
+            std::size_t SizeClass;
+        };
+
+        static_assert(sizeof(BlockHeader) <= HeaderSize, "Block header doesn't fit");
+
+        //Releases the pool of the thread when the thread exits
+        struct ThreadOwner
+        {
+            ErrorPool* Pool;
+
+            inline ThreadOwner() : Pool(nullptr) {}
+
+            inline ~ThreadOwner()
+            {
+                ThreadExited() = true;
+                ReleaseCurrent();
+            }
+        };
+
+        char* Arena;
+        std::size_t ArenaSize;
+        std::size_t ArenaUsed;
+        FreeBlock* LocalFree[ClassCount];
+        std::atomic<FreeBlock*> RemoteFree[ClassCount];
+
+        //1 for the owning thread and 1 for each allocated block
+        std::atomic<std::size_t> References;
+        ErrorPool* NextOrphan;
+
+        inline explicit ErrorPool(std::size_t size) :   Arena(new char[size]),
+                                                        ArenaSize(size),
+                                                        ArenaUsed(0),
+                                                        References(1),
+                                                        NextOrphan(nullptr)
+        {
+            //Touch the arena now so that allocations later don't page fault
+            std::memset(Arena, 0, size);
+            for(int i = 0; i < ClassCount; ++i)
+            {
+                LocalFree[i] = nullptr;
+                RemoteFree[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        ErrorPool(const ErrorPool&) = delete;
+        ErrorPool& operator=(const ErrorPool&) = delete;
+
+        inline ~ErrorPool()
+        {
+            delete[] Arena;
+        }
+
+        static inline ErrorPool*& Current()
+        {
+            static thread_local ErrorPool* pool = nullptr;
+            return pool;
+        }
+
+        static inline bool& ThreadExited()
+        {
+            static thread_local bool exited = false;
+            return exited;
+        }
+
+        static inline ThreadOwner& Owner()
+        {
+            static thread_local ThreadOwner owner;
+            return owner;
+        }
+
+        //Pools released by their thread while some of their blocks are still allocated
+        static inline std::atomic<ErrorPool*>& Orphans()
+        {
+            static std::atomic<ErrorPool*> orphans(nullptr);
+            return orphans;
+        }
+
+        //Reserves a pool of `size` bytes for the current thread, call this at thread start.
+        //Returns false if the current thread already has a pool.
+        static inline bool Reserve(std::size_t size)
+        {
+            if(Current() != nullptr || ThreadExited())
+                return false;
+
+            ErrorPool* pool = new ErrorPool(size);
+            Owner().Pool = pool;
+            Current() = pool;
+            return true;
+        }
+
+        static inline std::size_t BlockSize(int sizeClass)
+        {
+            return MinBlockSize << sizeClass;
+        }
+
+        //Returns -1 if `size` is larger than the largest block
+        static inline int SizeClassFor(std::size_t size)
+        {
+            for(int i = 0; i < ClassCount; ++i)
+            {
+                if(size + HeaderSize <= BlockSize(i))
+                    return i;
+            }
+            return -1;
+        }
+
+        //Usable size of an allocated block
+        static inline std::size_t PayloadSize(const void* ptr)
+        {
+            const BlockHeader* header =
+                reinterpret_cast<const BlockHeader*>(static_cast<const char*>(ptr) - HeaderSize);
+            return BlockSize((int)header->SizeClass) - HeaderSize;
+        }
+
+        //Returns nullptr if the current thread has no pool or its pool is exhausted
+        static inline void* Allocate(std::size_t size)
+        {
+            if(Current() == nullptr)
+            {
+                #if DS_REALTIME_LAZY_RESERVE
+                    if(!Reserve(DS_REALTIME_DEFAULT_POOL_SIZE))
+                        return nullptr;
+                #else
+                    return nullptr;
+                #endif
+            }
+
+            int sizeClass = SizeClassFor(size);
+            if(sizeClass < 0)
+                return nullptr;
+
+            return Current()->AllocateBlock(sizeClass);
+        }
+
+        static inline void Free(void* ptr)
+        {
+            BlockHeader* header =
+                reinterpret_cast<BlockHeader*>(static_cast<char*>(ptr) - HeaderSize);
+            ErrorPool* owner = header->Owner;
+            int sizeClass = (int)header->SizeClass;
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(header);
+
+            if(owner == Current())
+            {
+                block->Next = owner->LocalFree[sizeClass];
+                owner->LocalFree[sizeClass] = block;
+            }
+            else
+            {
+                FreeBlock* head = owner->RemoteFree[sizeClass].load(std::memory_order_relaxed);
+                do
+                    block->Next = head;
+                while(!owner->RemoteFree[sizeClass].compare_exchange_weak(head,
+                                                                        block,
+                                                                        std::memory_order_release,
+                                                                        std::memory_order_relaxed));
+            }
+            owner->References.fetch_sub(1, std::memory_order_release);
+        }
+
+        inline void* AllocateBlock(int sizeClass)
+        {
+            FreeBlock* block = LocalFree[sizeClass];
+            if(block == nullptr)
+                block = RemoteFree[sizeClass].exchange(nullptr, std::memory_order_acquire);
+
+            if(block != nullptr)
+                LocalFree[sizeClass] = block->Next;
+            else
+            {
+                if(ArenaSize - ArenaUsed < BlockSize(sizeClass))
+                    return nullptr;
+                block = reinterpret_cast<FreeBlock*>(Arena + ArenaUsed);
+                ArenaUsed += BlockSize(sizeClass);
+            }
+
+            References.fetch_add(1, std::memory_order_relaxed);
+            BlockHeader* header = reinterpret_cast<BlockHeader*>(block);
+            header->Owner = this;
+            header->SizeClass = (std::size_t)sizeClass;
+            return reinterpret_cast<char*>(block) + HeaderSize;
+        }
+
+        //Releases the pool of the current thread, then deletes the orphaned pools that have no
+        //allocated blocks left
+        static inline void ReleaseCurrent()
+        {
+            ErrorPool* pool = Current();
+            if(pool != nullptr)
+            {
+                Current() = nullptr;
+                Owner().Pool = nullptr;
+                if(pool->References.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    delete pool;
+                else
+                    PushOrphan(pool);
+            }
+            CollectOrphans();
+        }
+
+        static inline void PushOrphan(ErrorPool* pool)
+        {
+            ErrorPool* head = Orphans().load(std::memory_order_relaxed);
+            do
+                pool->NextOrphan = head;
+            while(!Orphans().compare_exchange_weak( head,
+                                                    pool,
+                                                    std::memory_order_release,
+                                                    std::memory_order_relaxed));
+        }
+
+        //Takes the whole list so that concurrent calls never see the same pool
+        static inline void CollectOrphans()
+        {
+            ErrorPool* pool = Orphans().exchange(nullptr, std::memory_order_acquire);
+            while(pool != nullptr)
+            {
+                ErrorPool* next = pool->NextOrphan;
+                if(pool->References.load(std::memory_order_acquire) == 0)
+                    delete pool;
+                else
+                    PushOrphan(pool);
+                pool = next;
+            }
+        }
+    };
+
+    //Reserves a pool of `size` bytes for the current thread, call this at thread start before any 
+    //error is created. Returns false if the current thread already has a pool.
+    inline bool ReserveErrorPool(std::size_t size)
+    {
+        return ErrorPool::Reserve(size);
+    }
+
+    //Releases the pool of the current thread, which is also done when the thread exits. The pool 
+    //is deleted once the errors allocated from it are destroyed, the orphaned pools of exited 
+    //threads are checked and deleted here as well. Not real-time safe.
+    inline void ReleaseErrorPool()
+    {
+        ErrorPool::ReleaseCurrent();
+    }
+
+    //String with storage from the error pool of the current thread. Appending is truncated with
+    //"..." when the pool is exhausted or `DS_REALTIME_MESSAGE_CAPACITY` is reached.
+    struct PoolString
+    {
+        char* Data;
+        std::size_t Size;
+        std::size_t Capacity;
+
+        inline PoolString() : Data(nullptr), Size(0), Capacity(0) {}
+
+        inline PoolString(const char* str, std::size_t length) : PoolString()
+        {
+            append(str, length);
+        }
+
+        inline PoolString(const char* str) : PoolString(str, std::strlen(str)) {}
+
+        inline PoolString(const std::string& str) : PoolString(str.data(), str.size()) {}
+
+        inline PoolString(const PoolString& other) : PoolString(other.Data, other.Size) {}
+
+        inline PoolString(PoolString&& other) noexcept :    Data(other.Data),
+                                                            Size(other.Size),
+                                                            Capacity(other.Capacity)
+        {
+            other.Data = nullptr;
+            other.Size = 0;
+            other.Capacity = 0;
+        }
+
+        inline PoolString& operator=(const PoolString& other)
+        {
+            if(this != &other)
+            {
+                clear();
+                append(other.Data, other.Size);
+            }
+            return *this;
+        }
+
+        inline PoolString& operator=(PoolString&& other) noexcept
+        {
+            if(this != &other)
+            {
+                if(Data != nullptr)
+                    ErrorPool::Free(Data);
+                Data = other.Data;
+                Size = other.Size;
+                Capacity = other.Capacity;
+                other.Data = nullptr;
+                other.Size = 0;
+                other.Capacity = 0;
+            }
+            return *this;
+        }
+
+        inline ~PoolString()
+        {
+            if(Data != nullptr)
+                ErrorPool::Free(Data);
+        }
+
+        inline const char* data() const { return Data != nullptr ? Data : ""; }
+        inline const char* c_str() const { return data(); }
+        inline std::size_t size() const { return Size; }
+        inline std::size_t length() const { return Size; }
+        inline std::size_t capacity() const { return Capacity; }
+        inline bool empty() const { return Size == 0; }
+
+        inline void reserve(std::size_t capacity)
+        {
+            Grow(capacity);
+        }
+
+        inline void clear()
+        {
+            Size = 0;
+            if(Data != nullptr)
+                Data[0] = '\0';
+        }
+
+        //Tries to grow to at least `needed` characters, keeps the current storage if it can't
+        inline void Grow(std::size_t needed)
+        {
+            const std::size_t maxCapacity = DS_REALTIME_MESSAGE_CAPACITY;
+            needed = needed < maxCapacity ? needed : maxCapacity;
+            if(needed <= Capacity)
+                return;
+
+            std::size_t desired = Capacity * 2 > needed ? Capacity * 2 : needed;
+            desired = desired < maxCapacity ? desired : maxCapacity;
+
+            char* newData = static_cast<char*>(ErrorPool::Allocate(desired + 1));
+            if(newData == nullptr && desired > needed)
+                newData = static_cast<char*>(ErrorPool::Allocate(needed + 1));
+            if(newData == nullptr)
+                return;
+
+            if(Data != nullptr)
+            {
+                std::memcpy(newData, Data, Size);
+                ErrorPool::Free(Data);
+            }
+            newData[Size] = '\0';
+            Data = newData;
+            Capacity = ErrorPool::PayloadSize(newData) - 1;
+            Capacity = Capacity < maxCapacity ? Capacity : maxCapacity;
+        }
+
+        inline PoolString& append(const char* str, std::size_t length)
+        {
+            if(Size + length > Capacity)
+                Grow(Size + length);
+
+            std::size_t count = Capacity - Size < length ? Capacity - Size : length;
+            if(count > 0)
+            {
+                std::memcpy(Data + Size, str, count);
+                Size += count;
+                Data[Size] = '\0';
+            }
+
+            if(count < length && Size >= 3)
+                std::memcpy(Data + Size - 3, "...", 3);
+            return *this;
+        }
+
+        inline PoolString& append(const char* str) { return append(str, std::strlen(str)); }
+        inline PoolString& append(const std::string& str) { return append(str.data(), str.size()); }
+        inline PoolString& operator+=(const char* str) { return append(str); }
+        inline PoolString& operator+=(const std::string& str) { return append(str); }
+
+        inline operator std::string() const
+        {
+            return std::string(data(), Size);
+        }
+    };
+
+    //Vector of trivially destructible elements with storage from the error pool of the current
+    //thread. The first element is stored inline so it can always be added.
+    //`TryPushBack()` returns false when the pool is exhausted or `MaxCount` is reached.
+    template<typename T, std::size_t MaxCount>
+    struct PoolVector
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "T must be trivially destructible");
+
+        T* Data;
+        std::size_t Size;
+        std::size_t Capacity;
+        alignas(T) unsigned char Inline[sizeof(T)];
+
+        inline PoolVector() : Data(InlineData()), Size(0), Capacity(1) {}
+
+        inline PoolVector(const PoolVector& other) : PoolVector()
+        {
+            for(std::size_t i = 0; i < other.Size && TryPushBack(other.Data[i]); ++i) {}
+        }
+
+        inline PoolVector(PoolVector&& other) noexcept : PoolVector()
+        {
+            *this = std::move(other);
+        }
+
+        inline PoolVector& operator=(const PoolVector& other)
+        {
+            if(this != &other)
+            {
+                clear();
+                for(std::size_t i = 0; i < other.Size && TryPushBack(other.Data[i]); ++i) {}
+            }
+            return *this;
+        }
+
+        inline PoolVector& operator=(PoolVector&& other) noexcept
+        {
+            if(this == &other)
+                return *this;
+
+            FreeData();
+            if(other.Data == other.InlineData())
+            {
+                Data = InlineData();
+                Capacity = 1;
+                if(other.Size > 0)
+                    new (Data) T(other.Data[0]);
+            }
+            else
+            {
+                Data = other.Data;
+                Capacity = other.Capacity;
+                other.Data = other.InlineData();
+                other.Capacity = 1;
+            }
+            Size = other.Size;
+            other.Size = 0;
+            return *this;
+        }
+
+        inline ~PoolVector()
+        {
+            FreeData();
+        }
+
+        inline T* InlineData() { return reinterpret_cast<T*>(Inline); }
+        inline const T* InlineData() const { return reinterpret_cast<const T*>(Inline); }
+
+        inline void FreeData()
+        {
+            if(Data != InlineData())
+                ErrorPool::Free(Data);
+            Data = InlineData();
+            Capacity = 1;
+        }
+
+        inline std::size_t size() const { return Size; }
+        inline std::size_t capacity() const { return Capacity; }
+        inline bool empty() const { return Size == 0; }
+        inline T* data() { return Data; }
+        inline const T* data() const { return Data; }
+        inline T* begin() { return Data; }
+        inline const T* begin() const { return Data; }
+        inline T* end() { return Data + Size; }
+        inline const T* end() const { return Data + Size; }
+        inline T& operator[](std::size_t index) { return Data[index]; }
+        inline const T& operator[](std::size_t index) const { return Data[index]; }
+        inline T& back() { return Data[Size - 1]; }
+        inline const T& back() const { return Data[Size - 1]; }
+        inline void clear() { Size = 0; }
+
+        inline T* erase(T* first, T* last)
+        {
+            T* out = first;
+            for(T* it = last; it != end(); ++it, ++out)
+                *out = *it;
+            Size = (std::size_t)(out - Data);
+            return first;
+        }
+
+        //Tries to grow by at least 1 element, keeps the current storage if it can't
+        inline void Grow()
+        {
+            if(Capacity >= MaxCount)
+                return;
+
+            std::size_t desired = Capacity < 2 ? 4 : Capacity * 2;
+            desired = desired < MaxCount ? desired : MaxCount;
+
+            void* newMemory = ErrorPool::Allocate(desired * sizeof(T));
+            if(newMemory == nullptr)
+                newMemory = ErrorPool::Allocate((Capacity + 1) * sizeof(T));
+            if(newMemory == nullptr)
+                return;
+
+            T* newData = static_cast<T*>(newMemory);
+            for(std::size_t i = 0; i < Size; ++i)
+                new (newData + i) T(Data[i]);
+
+            FreeData();
+            Data = newData;
+            Capacity = ErrorPool::PayloadSize(newMemory) / sizeof(T);
+            Capacity = Capacity < MaxCount ? Capacity : MaxCount;
+        }
+
+        inline bool TryPushBack(const T& value)
+        {
+            if(Size == Capacity)
+                Grow();
+            if(Size == Capacity)
+                return false;
+
+            new (Data + Size) T(value);
+            ++Size;
+            return true;
+        }
+
+        inline void push_back(const T& value) { TryPushBack(value); }
+        inline void emplace_back(const T& value) { TryPushBack(value); }
+    };
+}
+
+#endif
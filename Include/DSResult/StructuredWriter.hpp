@@ -0,0 +1,555 @@
+#ifndef DS_RESULT_STRUCTURED_WRITER_HPP
+#define DS_RESULT_STRUCTURED_WRITER_HPP
+
+#include "DSResult.hpp"
+
+#include <cstdio>
+#include <cstddef>
+#include <cerrno>
+
+#if defined(_WIN32)
+    #include <io.h>
+#elif defined(__unix__) || defined(__APPLE__)
+    #include <unistd.h>
+#endif
+
+namespace DS
+{
+    enum class StructuredFormat : unsigned char
+    {
+        //{"message":"...","code":0,"frames":[{"function":"...","file":"...","line":0}]}
+        //"category" follows "code" for errors from a `std::error_code`
+        Json,
+
+        //message="..." code=0 frame.0.function=... frame.0.file=... frame.0.line=0
+        //category=... follows code=... for errors from a `std::error_code`
+        Logfmt
+    };
+
+    //The fields written for an error, from an `ErrorTrace` or an entry of an `ErrorList`.
+    //When `Category` is set, "message" is `Message` followed by ": " and `Description`, the
+    //description of `ErrorCode`. The category name is only written in "category".
+    struct StructuredRecord
+    {
+        const char* Message;
+        std::size_t MessageSize;
+        const char* Description;
+        std::size_t DescriptionSize;
+        int ErrorCode;
+        const std::error_category* Category;
+        const TraceElement* Frames;
+        int FrameCount;
+        
+        //`FrameIndex` is relative to `Frames`
+        const TraceContext* Contexts;
+        std::size_t ContextCount;
+        int OmittedFrames;
+        int OmittedIndex;
+    };
+
+    //Streams an error trace through a fixed size buffer without building intermediate strings.
+    //When the buffer is full, it is passed to `Flush`. Without `Flush`, the output is truncated
+    //and `TotalSize` keeps counting the bytes the full record needs.
+    struct StructuredWriter
+    {
+        typedef bool (*FlushFunction)(void* target, const char* data, std::size_t size);
+
+        char* Buffer;
+        std::size_t Capacity;
+        std::size_t Size;
+        std::size_t TotalSize;
+        FlushFunction Flush;
+        void* Target;
+        bool Failed;
+
+        inline StructuredWriter(char* buffer,
+                                std::size_t capacity,
+                                FlushFunction flush,
+                                void* target) : Buffer(buffer),
+                                                Capacity(capacity),
+                                                Size(0),
+                                                TotalSize(0),
+                                                Flush(flush),
+                                                Target(target),
+                                                Failed(false)
+        {}
+
+        inline bool FlushBuffer()
+        {
+            if(Flush != nullptr && Size > 0)
+            {
+                if(!Failed && !Flush(Target, Buffer, Size))
+                    Failed = true;
+                Size = 0;
+            }
+            return !Failed;
+        }
+
+        inline void Put(char c)
+        {
+            ++TotalSize;
+            if(Size == Capacity && !FlushBuffer())
+                return;
+            if(Size < Capacity)
+                Buffer[Size++] = c;
+        }
+
+        inline void Put(const char* str, std::size_t length)
+        {
+            TotalSize += length;
+            while(length > 0)
+            {
+                if(Size == Capacity && (Flush == nullptr || Capacity == 0 || !FlushBuffer()))
+                    return;
+
+                std::size_t count = Capacity - Size < length ? Capacity - Size : length;
+                std::memcpy(Buffer + Size, str, count);
+                Size += count;
+                str += count;
+                length -= count;
+            }
+        }
+
+        inline void Put(const char* str)
+        {
+            Put(str, std::strlen(str));
+        }
+
+        //Same as `Put()`, for the functions that append to a string type
+        inline void append(const char* str, std::size_t length)
+        {
+            Put(str, length);
+        }
+
+        inline void PutInt(long long value)
+        {
+            InternalAppendInt(*this, value);
+        }
+
+        inline void PutEscapedChar(unsigned char c)
+        {
+            const char hex[] = "0123456789abcdef";
+            switch(c)
+            {
+                case '"':   Put("\\\"", 2); return;
+                case '\\':  Put("\\\\", 2); return;
+                case '\n':  Put("\\n", 2);  return;
+                case '\r':  Put("\\r", 2);  return;
+                case '\t':  Put("\\t", 2);  return;
+                case '\b':  Put("\\b", 2);  return;
+                case '\f':  Put("\\f", 2);  return;
+                default:
+                    if(c < 0x20)
+                    {
+                        Put("\\u00", 4);
+                        Put(hex[c >> 4]);
+                        Put(hex[c & 0xF]);
+                    }
+                    else
+                        Put((char)c);
+                    return;
+            }
+        }
+
+        inline void PutEscaped(const char* str, std::size_t length)
+        {
+            std::size_t runStart = 0;
+            for(std::size_t i = 0; i < length; ++i)
+            {
+                unsigned char c = (unsigned char)str[i];
+                if(c >= 0x20 && c != '"' && c != '\\')
+                    continue;
+
+                Put(str + runStart, i - runStart);
+                PutEscapedChar(c);
+                runStart = i + 1;
+            }
+            Put(str + runStart, length - runStart);
+        }
+
+        //Escapes into a quoted string, which is valid for both JSON and logfmt
+        inline void PutQuoted(const char* str, std::size_t length)
+        {
+            Put('"');
+            PutEscaped(str, length);
+            Put('"');
+        }
+
+        inline void PutQuoted(const char* str)
+        {
+            PutQuoted(str, std::strlen(str));
+        }
+
+        //logfmt values are only quoted when needed
+        inline void PutLogfmtValue(const char* str, std::size_t length)
+        {
+            bool needsQuote = length == 0;
+            for(std::size_t i = 0; i < length && !needsQuote; ++i)
+            {
+                unsigned char c = (unsigned char)str[i];
+                needsQuote = c <= ' ' || c == '=' || c == '"' || c == '\\';
+            }
+
+            if(needsQuote)
+                PutQuoted(str, length);
+            else
+                Put(str, length);
+        }
+
+        //logfmt keys cannot be quoted, invalid characters are replaced with '_'
+        inline void PutLogfmtKey(const char* str)
+        {
+            for(; *str != '\0'; ++str)
+            {
+                unsigned char c = (unsigned char)*str;
+                Put(c <= ' ' || c == '=' || c == '"' ? '_' : (char)c);
+            }
+        }
+
+        inline void PutLogfmtFrameKey(int frameIndex, const char* field)
+        {
+            Put(" frame.", 7);
+            PutInt(frameIndex);
+            Put('.');
+            Put(field);
+        }
+
+        inline void WriteJsonContext(const TraceContext& context)
+        {
+            switch(context.ContextKind)
+            {
+                case TraceContext::Kind::StaticString:
+                    Put("{\"note\":", 8);
+                    PutQuoted(context.Key);
+                    break;
+                case TraceContext::Kind::KeyValue:
+                    Put("{\"key\":", 7);
+                    PutQuoted(context.Key);
+                    Put(",\"value\":", 9);
+                    PutInt(context.Value);
+                    break;
+                case TraceContext::Kind::CapturedString:
+                default:
+                    Put("{\"key\":", 7);
+                    PutQuoted(context.Key);
+                    Put(",\"value\":", 9);
+                    PutQuoted(context.Captured);
+                    break;
+            }
+            Put('}');
+        }
+
+        //The message and the description are quoted together
+        inline void PutRecordMessage(const StructuredRecord& record)
+        {
+            Put('"');
+            PutEscaped(record.Message, record.MessageSize);
+            if(record.Category != nullptr)
+            {
+                if(record.MessageSize > 0)
+                    Put(": ", 2);
+                PutEscaped(record.Description, record.DescriptionSize);
+            }
+            Put('"');
+        }
+
+        inline void WriteJson(const StructuredRecord& record)
+        {
+            Put("{\"message\":", 11);
+            PutRecordMessage(record);
+            Put(",\"code\":", 8);
+            PutInt(record.ErrorCode);
+            if(record.Category != nullptr)
+            {
+                Put(",\"category\":", 12);
+                PutQuoted(record.Category->name());
+            }
+            Put(",\"frames\":[", 11);
+
+            std::size_t contextIndex = 0;
+            for(int i = 0; i < record.FrameCount; ++i)
+            {
+                const TraceElement& element = record.Frames[i];
+                if(i != 0)
+                    Put(',');
+                Put("{\"function\":", 12);
+                PutQuoted(element.Function);
+                Put(",\"file\":", 8);
+                PutQuoted(element.File);
+                Put(",\"line\":", 8);
+                PutInt(element.Line);
+                if(element.Repeat > 1)
+                {
+                    Put(",\"repeat\":", 10);
+                    PutInt(element.Repeat);
+                }
+
+                if( contextIndex < record.ContextCount &&
+                    record.Contexts[contextIndex].FrameIndex <= i)
+                {
+                    Put(",\"context\":[", 12);
+                    bool first = true;
+                    while(  contextIndex < record.ContextCount &&
+                            record.Contexts[contextIndex].FrameIndex <= i)
+                    {
+                        if(!first)
+                            Put(',');
+                        first = false;
+                        WriteJsonContext(record.Contexts[contextIndex++]);
+                    }
+                    Put(']');
+                }
+                Put('}');
+            }
+            Put(']');
+
+            if(record.OmittedFrames > 0)
+            {
+                Put(",\"omitted_frames\":", 18);
+                PutInt(record.OmittedFrames);
+                Put(",\"omitted_index\":", 17);
+                PutInt(record.OmittedIndex);
+            }
+            Put('}');
+        }
+
+        inline void WriteLogfmtContext(int frameIndex, const TraceContext& context)
+        {
+            switch(context.ContextKind)
+            {
+                case TraceContext::Kind::StaticString:
+                    PutLogfmtFrameKey(frameIndex, "note=");
+                    PutLogfmtValue(context.Key, std::strlen(context.Key));
+                    break;
+                case TraceContext::Kind::KeyValue:
+                    PutLogfmtFrameKey(frameIndex, "ctx.");
+                    PutLogfmtKey(context.Key);
+                    Put('=');
+                    PutInt(context.Value);
+                    break;
+                case TraceContext::Kind::CapturedString:
+                default:
+                    PutLogfmtFrameKey(frameIndex, "ctx.");
+                    PutLogfmtKey(context.Key);
+                    Put('=');
+                    PutLogfmtValue(context.Captured, std::strlen(context.Captured));
+                    break;
+            }
+        }
+
+        inline void WriteLogfmt(const StructuredRecord& record)
+        {
+            Put("message=", 8);
+            if(record.Category == nullptr)
+                PutLogfmtValue(record.Message, record.MessageSize);
+            else
+                PutRecordMessage(record);
+            Put(" code=", 6);
+            PutInt(record.ErrorCode);
+            if(record.Category != nullptr)
+            {
+                Put(" category=", 10);
+                PutLogfmtValue(record.Category->name(), std::strlen(record.Category->name()));
+            }
+
+            std::size_t contextIndex = 0;
+            for(int i = 0; i < record.FrameCount; ++i)
+            {
+                const TraceElement& element = record.Frames[i];
+                PutLogfmtFrameKey(i, "function=");
+                PutLogfmtValue(element.Function, std::strlen(element.Function));
+                PutLogfmtFrameKey(i, "file=");
+                PutLogfmtValue(element.File, std::strlen(element.File));
+                PutLogfmtFrameKey(i, "line=");
+                PutInt(element.Line);
+                if(element.Repeat > 1)
+                {
+                    PutLogfmtFrameKey(i, "repeat=");
+                    PutInt(element.Repeat);
+                }
+
+                while(  contextIndex < record.ContextCount &&
+                        record.Contexts[contextIndex].FrameIndex <= i)
+                {
+                    WriteLogfmtContext(i, record.Contexts[contextIndex++]);
+                }
+            }
+
+            if(record.OmittedFrames > 0)
+            {
+                Put(" omitted_frames=", 16);
+                PutInt(record.OmittedFrames);
+                Put(" omitted_index=", 15);
+                PutInt(record.OmittedIndex);
+            }
+        }
+
+        inline void Write(const StructuredRecord& record, StructuredFormat format)
+        {
+            if(format == StructuredFormat::Json)
+                WriteJson(record);
+            else
+                WriteLogfmt(record);
+        }
+
+        inline void Write(const ErrorTrace& trace, StructuredFormat format)
+        {
+            StructuredRecord record;
+            record.Message = trace.Message.data();
+            record.MessageSize = trace.Message.size();
+            record.Description = nullptr;
+            record.DescriptionSize = 0;
+            record.ErrorCode = trace.ErrorCode;
+            record.Category = trace.Category;
+            record.Frames = trace.Stack.data();
+            record.FrameCount = (int)trace.Stack.size();
+            record.Contexts = trace.Contexts.data();
+            record.ContextCount = trace.Contexts.size();
+            record.OmittedFrames = trace.OmittedFrames;
+            record.OmittedIndex = trace.OmittedIndex;
+            
+            if(trace.Category == nullptr)
+                Write(record, format);
+            else
+            {
+                //Only available as a string from the category
+                const std::string description = trace.Category->message(trace.ErrorCode);
+                record.Description = description.data();
+                record.DescriptionSize = description.size();
+                Write(record, format);
+            }
+        }
+
+        //One record per entry, separated by newlines
+        inline void Write(const ErrorList& list, StructuredFormat format)
+        {
+            for(std::size_t i = 0; i < list.Entries.size(); ++i)
+            {
+                const ErrorList::Entry& entry = list.Entries[i];
+                StructuredRecord record;
+                record.Message = list.Messages.data() + entry.MessageOffset;
+                record.MessageSize = entry.TextSize;
+                record.Description = record.Message + entry.MessageSize - entry.DescriptionSize;
+                record.DescriptionSize = entry.DescriptionSize;
+                record.ErrorCode = entry.ErrorCode;
+                record.Category = entry.Category;
+                record.Frames = list.Frames.data() + entry.FrameOffset;
+                record.FrameCount = (int)entry.FrameCount;
+                record.Contexts = list.Contexts.data() + entry.ContextOffset;
+                record.ContextCount = entry.ContextCount;
+                record.OmittedFrames = entry.OmittedFrames;
+                record.OmittedIndex = entry.OmittedIndex;
+                
+                if(i != 0)
+                    Put('\n');
+                Write(record, format);
+            }
+        }
+    };
+
+    inline bool InternalFlushToFile(void* target, const char* data, std::size_t size)
+    {
+        return std::fwrite(data, 1, size, static_cast<std::FILE*>(target)) == size;
+    }
+
+    #if defined(_WIN32) || defined(__unix__) || defined(__APPLE__)
+        inline bool InternalFlushToFd(void* target, const char* data, std::size_t size)
+        {
+            int fd = *static_cast<int*>(target);
+            while(size > 0)
+            {
+                #if defined(_WIN32)
+                    int written = _write(fd, data, (unsigned int)size);
+                #else
+                    ssize_t written = write(fd, data, size);
+                #endif
+
+                if(written < 0)
+                {
+                    if(errno == EINTR)
+                        continue;
+                    return false;
+                }
+                data += written;
+                size -= (std::size_t)written;
+            }
+            return true;
+        }
+    #endif
+
+    //Writes the record into `buffer`, truncated and null terminated if it doesn't fit.
+    //Returns the length of the full record, excluding the null terminator.
+    inline std::size_t WriteStructured( const ErrorTrace& trace,
+                                        StructuredFormat format,
+                                        char* buffer,
+                                        std::size_t size)
+    {
+        StructuredWriter writer(buffer, size == 0 ? 0 : size - 1, nullptr, nullptr);
+        writer.Write(trace, format);
+        if(size > 0)
+            buffer[writer.Size] = '\0';
+        return writer.TotalSize;
+    }
+
+    //Writes the record followed by a newline. Returns false if writing failed.
+    inline bool WriteStructured(const ErrorTrace& trace, StructuredFormat format, std::FILE* file)
+    {
+        char buffer[512];
+        StructuredWriter writer(buffer, sizeof(buffer), InternalFlushToFile, file);
+        writer.Write(trace, format);
+        writer.Put('\n');
+        return writer.FlushBuffer();
+    }
+
+    #if defined(_WIN32) || defined(__unix__) || defined(__APPLE__)
+        //Writes the record followed by a newline. Returns false if writing failed.
+        inline bool WriteStructured(const ErrorTrace& trace, StructuredFormat format, int fd)
+        {
+            char buffer[512];
+            StructuredWriter writer(buffer, sizeof(buffer), InternalFlushToFd, &fd);
+            writer.Write(trace, format);
+            writer.Put('\n');
+            return writer.FlushBuffer();
+        }
+    #endif
+
+    //Writes a record for each error of the list, separated by newlines. Same as the `ErrorTrace` 
+    //overload otherwise.
+    inline std::size_t WriteStructured( const ErrorList& list,
+                                        StructuredFormat format,
+                                        char* buffer,
+                                        std::size_t size)
+    {
+        StructuredWriter writer(buffer, size == 0 ? 0 : size - 1, nullptr, nullptr);
+        writer.Write(list, format);
+        if(size > 0)
+            buffer[writer.Size] = '\0';
+        return writer.TotalSize;
+    }
+
+    //Writes a line for each error of the list. Returns false if writing failed.
+    inline bool WriteStructured(const ErrorList& list, StructuredFormat format, std::FILE* file)
+    {
+        char buffer[512];
+        StructuredWriter writer(buffer, sizeof(buffer), InternalFlushToFile, file);
+        writer.Write(list, format);
+        if(!list.Empty())
+            writer.Put('\n');
+        return writer.FlushBuffer();
+    }
+
+    #if defined(_WIN32) || defined(__unix__) || defined(__APPLE__)
+        //Writes a line for each error of the list. Returns false if writing failed.
+        inline bool WriteStructured(const ErrorList& list, StructuredFormat format, int fd)
+        {
+            char buffer[512];
+            StructuredWriter writer(buffer, sizeof(buffer), InternalFlushToFd, &fd);
+            writer.Write(list, format);
+            if(!list.Empty())
+                writer.Put('\n');
+            return writer.FlushBuffer();
+        }
+    #endif
+}
+
+#endif
@@ -0,0 +1,542 @@
+#include "DSResult/DSResult.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+//Counts every allocation made through operator new, which is what std::string, std::vector and
+//the expected backends allocate with. Single threaded, the counters are only read on this thread.
+namespace
+{
+    long AllocationCount = 0;
+    long CopyCount = 0;
+    long MoveCount = 0;
+    int FailedCount = 0;
+}
+
+void* operator new(std::size_t size)
+{
+    ++AllocationCount;
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+    if(ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    ++AllocationCount;
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+//gcc treats operator new as its own allocation function and warns when the memory reaches
+//std::free once both replacements are inlined, even though the replacement new uses std::malloc.
+//The warning was added in gcc 11.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+    #pragma GCC diagnostic pop
+#endif
+
+//Value type that counts its copies and moves
+struct Counted
+{
+    int Value;
+
+    Counted() : Value(0) {}
+    Counted(int value) : Value(value) {}
+    Counted(const Counted& other) : Value(other.Value) { ++CopyCount; }
+    Counted(Counted&& other) : Value(other.Value) { ++MoveCount; }
+    Counted& operator=(const Counted& other) { Value = other.Value; ++CopyCount; return *this; }
+    Counted& operator=(Counted&& other) { Value = other.Value; ++MoveCount; return *this; }
+};
+
+//Depth of the error path, each level appends the same frame which is merged by `Repeat`
+const int ErrorDepth = 100;
+
+DS::Result<Counted> Leaf(bool fail)
+{
+    if(fail)
+        return DS_ERROR_MSG("Leaf failed");
+    return Counted(1);
+}
+
+DS::Result<void> VoidLeaf(bool fail)
+{
+    if(fail)
+        return DS_ERROR_MSG("Leaf failed");
+    return {};
+}
+
+DS::Result<Counted> Try(int depth, bool fail)
+{
+    if(depth == 0)
+        return Leaf(fail);
+    Counted value = Try(depth - 1, fail).DS_TRY();
+    return value;
+}
+
+DS::Result<Counted> TryAct(int depth, bool fail)
+{
+    if(depth == 0)
+        return Leaf(fail);
+    Counted value = TryAct(depth - 1, fail)
+                        .DS_TRY_ACT(return DS::Error(std::move(DS_APPEND_TRACE(DS_TMP_ERROR))));
+    return value;
+}
+
+//`DS_TRY` and `DS_VALUE_OR` on a named result read its error without moving it
+DS::Result<Counted> LvalueTry(int depth, bool fail)
+{
+    if(depth == 0)
+        return Leaf(fail);
+    DS::Result<Counted> result = LvalueTry(depth - 1, fail);
+    Counted value = result.DS_TRY();
+    return value;
+}
+
+DS::Result<Counted> LvalueValueOr(int depth, bool fail)
+{
+    if(depth == 0)
+        return Leaf(fail);
+    DS::Result<Counted> result = LvalueValueOr(depth - 1, fail);
+    Counted value = result.DS_VALUE_OR();
+    DS_CHECK_PREV();
+    return value;
+}
+
+DS::Result<Counted> CheckPrev(int depth, bool fail)
+{
+    if(depth == 0)
+        return Leaf(fail);
+    Counted value = CheckPrev(depth - 1, fail).DS_VALUE_OR();
+    DS_CHECK_PREV();
+    return value;
+}
+
+DS::Result<Counted> CheckPrevAct(int depth, bool fail)
+{
+    if(depth == 0)
+        return Leaf(fail);
+    Counted value = CheckPrevAct(depth - 1, fail).DS_VALUE_OR();
+    DS_CHECK_PREV_ACT(return DS::Error(std::move(DS_APPEND_TRACE(DS_TMP_ERROR))));
+    return value;
+}
+
+DS::Result<Counted> UnwrapDecl(int depth, bool fail)
+{
+    if(depth == 0)
+        return Leaf(fail);
+    DS_UNWRAP_DECL(Counted value, UnwrapDecl(depth - 1, fail));
+    return value;
+}
+
+DS::Result<Counted> UnwrapAssign(int depth, bool fail)
+{
+    if(depth == 0)
+        return Leaf(fail);
+    Counted value;
+    DS_UNWRAP_ASSIGN(value, UnwrapAssign(depth - 1, fail));
+    return value;
+}
+
+DS::Result<void> UnwrapVoid(int depth, bool fail)
+{
+    if(depth == 0)
+        return VoidLeaf(fail);
+    DS_UNWRAP_VOID(UnwrapVoid(depth - 1, fail));
+    return {};
+}
+
+DS::Result<Counted> UnwrapDeclAct(int depth, bool fail)
+{
+    if(depth == 0)
+        return Leaf(fail);
+    DS_UNWRAP_DECL_ACT(Counted value, 
+                       UnwrapDeclAct(depth - 1, fail), 
+                       return DS::Error(std::move(DS_APPEND_TRACE(DS_TMP_ERROR))));
+    return value;
+}
+
+DS::Result<Counted> UnwrapAssignAct(int depth, bool fail)
+{
+    if(depth == 0)
+        return Leaf(fail);
+    Counted value;
+    DS_UNWRAP_ASSIGN_ACT(   value, 
+                            UnwrapAssignAct(depth - 1, fail), 
+                            return DS::Error(std::move(DS_APPEND_TRACE(DS_TMP_ERROR))));
+    return value;
+}
+
+DS::Result<void> UnwrapVoidAct(int depth, bool fail)
+{
+    if(depth == 0)
+        return VoidLeaf(fail);
+    DS_UNWRAP_VOID_ACT( UnwrapVoidAct(depth - 1, fail), 
+                        return DS::Error(std::move(DS_APPEND_TRACE(DS_TMP_ERROR))));
+    return {};
+}
+
+DS::Result<void> Check(int depth, bool fail)
+{
+    if(depth == 0)
+        return VoidLeaf(fail);
+    DS::Result<void> result = Check(depth - 1, fail);
+    DS_CHECK(result);
+    return {};
+}
+
+DS::Result<void> CheckAct(int depth, bool fail)
+{
+    if(depth == 0)
+        return VoidLeaf(fail);
+    DS::Result<void> result = CheckAct(depth - 1, fail);
+    DS_CHECK_ACT(result, return DS::Error(std::move(DS_APPEND_TRACE(result.error()))));
+    return {};
+}
+
+DS::Result<void> CheckCtx(int depth, bool fail)
+{
+    if(depth == 0)
+        return VoidLeaf(fail);
+    DS::Result<void> result = CheckCtx(depth - 1, fail);
+    DS_CHECK_CTX(result, DS_CTX("Checking"));
+    return {};
+}
+
+DS::Result<void> Assert(int depth, bool fail)
+{
+    if(depth == 0)
+    {
+        int value = fail ? 1 : 2;
+        DS_ASSERT_EQ(value, 2);
+        DS_ASSERT_GT_EQ_EC(value, 2, 3);
+        return {};
+    }
+    DS_UNWRAP_VOID(Assert(depth - 1, fail));
+    return {};
+}
+
+//Each assert macro is checked on its own
+DS::Result<void> AssertTrue(int depth, bool fail)
+{
+    if(depth == 0)
+    {
+        int value = fail ? 1 : 2;
+        DS_ASSERT_TRUE(value == 2);
+        return {};
+    }
+    DS_UNWRAP_VOID(AssertTrue(depth - 1, fail));
+    return {};
+}
+
+DS::Result<void> AssertFalse(int depth, bool fail)
+{
+    if(depth == 0)
+    {
+        int value = fail ? 1 : 2;
+        DS_ASSERT_FALSE(value != 2);
+        return {};
+    }
+    DS_UNWRAP_VOID(AssertFalse(depth - 1, fail));
+    return {};
+}
+
+DS::Result<void> AssertNotEq(int depth, bool fail)
+{
+    if(depth == 0)
+    {
+        int value = fail ? 1 : 2;
+        DS_ASSERT_NOT_EQ(value, 1);
+        return {};
+    }
+    DS_UNWRAP_VOID(AssertNotEq(depth - 1, fail));
+    return {};
+}
+
+DS::Result<void> AssertLt(int depth, bool fail)
+{
+    if(depth == 0)
+    {
+        int value = fail ? 3 : 2;
+        DS_ASSERT_LT(value, 3);
+        return {};
+    }
+    DS_UNWRAP_VOID(AssertLt(depth - 1, fail));
+    return {};
+}
+
+//Allocated before the counters are reset
+std::vector<int> ExpectedRange(1024, 7);
+std::vector<int> ActualRange(1024, 7);
+
+DS::Result<void> AssertRange(int depth, bool fail)
+{
+    if(depth == 0)
+    {
+        ActualRange[1000] = fail ? 0 : 7;
+        DS_ASSERT_RANGE_EQ(ActualRange, ExpectedRange);
+        return {};
+    }
+    DS_UNWRAP_VOID(AssertRange(depth - 1, fail));
+    return {};
+}
+
+DS::Result<void> AssertBytes(int depth, bool fail)
+{
+    if(depth == 0)
+    {
+        ActualRange[1000] = fail ? 0 : 7;
+        DS_ASSERT_BYTES_EQ(ActualRange.data(), ExpectedRange.data(), 1024 * sizeof(int));
+        return {};
+    }
+    DS_UNWRAP_VOID(AssertBytes(depth - 1, fail));
+    return {};
+}
+
+DS::Result<void> CheckErrorCode(int depth, bool fail)
+{
+    if(depth == 0)
+    {
+        std::error_code errorCode = fail ? std::make_error_code(std::errc::io_error) : 
+                                           std::error_code();
+        DS_CHECK_ERROR_CODE(errorCode);
+        return {};
+    }
+    DS_UNWRAP_VOID(CheckErrorCode(depth - 1, fail));
+    return {};
+}
+
+//Only the success path is counted, throwing allocates the exception and its message
+DS::Result<Counted> Catch(int depth, bool fail)
+{
+    if(depth == 0)
+    {
+        return DS_CATCH([fail]()
+        {
+            if(fail)
+                throw std::runtime_error("Leaf failed");
+            return Counted(1);
+        });
+    }
+    DS_UNWRAP_DECL(Counted value, Catch(depth - 1, fail));
+    return value;
+}
+
+DS::Result<Counted> Combinators(int depth, bool fail)
+{
+    if(depth == 0)
+        return Leaf(fail);
+    return Combinators(depth - 1, fail)
+        .DS_MAP([](Counted value) { return Counted(value.Value + 1); })
+        .DS_AND_THEN([](Counted value) { return DS::Result<Counted>(std::move(value)); });
+}
+
+void Expect(const char* name, bool fail, int depth, long allocations, long copies, long moves)
+{
+    if(AllocationCount == allocations && CopyCount == copies && MoveCount == moves)
+        return;
+
+    ++FailedCount;
+    std::printf("FAILED %s (%s path, depth %d): %ld allocations (budget %ld), "
+                "%ld copies (budget %ld), %ld moves (budget %ld)\n",
+                name,
+                fail ? "error" : "success",
+                depth,
+                AllocationCount,
+                allocations,
+                CopyCount,
+                copies,
+                MoveCount,
+                moves);
+}
+
+#if DS_USE_NATIVE_EXPECTED && !DS_USE_REALTIME_POOL
+    //Error boxes allocated by the native expected, which doesn't use the error pool
+    #define NATIVE_BOXES(count) (count)
+#else
+    #define NATIVE_BOXES(count) 0
+#endif
+
+//Each budget starts without the error boxes kept by the thread from the previous one
+void ClearNativeCache()
+{
+    #if DS_USE_NATIVE_EXPECTED && !DS_USE_REALTIME_POOL
+        DS::InternalNativeBox<DS::ErrorTrace>::ClearThreadCache();
+    #endif
+}
+
+#define EXPECT_BUDGET(function, fail, depth, allocations, copies, moves) \
+    do \
+    { \
+        ClearNativeCache(); \
+        AllocationCount = 0; \
+        CopyCount = 0; \
+        MoveCount = 0; \
+        { \
+            auto result = function(depth, fail); \
+            if(result.HasValue() == fail) \
+            { \
+                ++FailedCount; \
+                std::printf("FAILED %s: unexpected result\n", #function); \
+            } \
+        } \
+        Expect(#function, fail, depth, allocations, copies, moves); \
+    } \
+    while(false)
+
+int main()
+{
+    #if DS_USE_REALTIME_POOL
+        //Without a reserved pool, the error is truncated instead of reserving one
+        EXPECT_BUDGET(Try, true, 1, 0, 0, 0);
+        EXPECT_BUDGET(CheckCtx, true, ErrorDepth, 0, 0, 0);
+        EXPECT_BUDGET(Assert, true, 1, 0, 0, 0);
+        
+        //Named results are read through the const error, which must still be propagated
+        EXPECT_BUDGET(LvalueTry, true, 1, 0, 0, 0);
+        EXPECT_BUDGET(LvalueValueOr, true, 1, 0, 0, 0);
+        
+        #if DS_USE_NATIVE_EXPECTED
+            //The errors that can't be boxed share the scratch error of the thread, so the last one
+            //replaces the others
+            {
+                DS::Result<void> first = DS_ERROR_MSG_EC("First", 1);
+                DS::Result<void> second = DS_ERROR_MSG_EC("Second", 2);
+                const DS::Result<void>& constFirst = first;
+                if( constFirst.HasValue() || 
+                    &constFirst.error() != &second.error() || 
+                    constFirst.error().ErrorCode != 2)
+                {
+                    ++FailedCount;
+                    std::printf("FAILED The errors without a box don't share the scratch error\n");
+                }
+            }
+        #endif
+        
+        //Nothing is allocated once the pool is reserved
+        DS::ReserveErrorPool(64 * 1024);
+        const long stackAllocations = 0;
+        const long messageAllocations = 0;
+        
+        //The range and bytes messages are formatted in the pool directly
+        const long rangeMessageAllocations = 0;
+        const long contextAllocations[] = { 0, 0 };
+        const long combinatorAllocations[] = { 0, 0 };
+    #else
+        //The frames reserved with the leaf frame, the recursive frame is merged by `Repeat` 
+        //regardless of the depth. The messages fit in the small string buffer.
+        const long stackAllocations = 1;
+        
+        //The assert message is reserved once
+        const long messageAllocations = 1;
+        
+        //The range and bytes messages are formatted in a reserved std::string which is then moved
+        const long rangeMessageAllocations = 1;
+        
+        //Frames with contexts aren't merged. The contexts are reserved to the capacity of the 
+        //stack, so both grow together from `DS_TRACE_RESERVE_FRAMES` (8): (1 + 1) at depth 1 
+        //and (5 + 5) for 101 frames and 100 contexts
+        const long contextAllocations[] = { 2, 10 };
+        
+        //The `DS_MAP` and `DS_AND_THEN` frames alternate. 3 frames at depth 1, and at depth 100
+        //the stack stops growing at `DS_MAX_TRACE_DEPTH` (128) frames after 5 allocations.
+        const long combinatorAllocations[] = { 1, 5 };
+    #endif
+
+    const int depths[] = { 1, ErrorDepth };
+    for(int i = 0; i < 2; ++i)
+    {
+        const int depth = depths[i];
+        
+        //Each level moves the value out of the result below it and into its own result, after the
+        //leaf moves it into the first result. Each combinator moves it in and out again.
+        const long valueMoves = 2 * depth + 1;
+        const long combinatorMoves = 4 * depth + 1;
+        
+        EXPECT_BUDGET(Try, false, depth, 0, 0, valueMoves);
+        EXPECT_BUDGET(TryAct, false, depth, 0, 0, valueMoves);
+        EXPECT_BUDGET(CheckPrev, false, depth, 0, 0, valueMoves);
+        EXPECT_BUDGET(CheckPrevAct, false, depth, 0, 0, valueMoves);
+        EXPECT_BUDGET(UnwrapDecl, false, depth, 0, 0, valueMoves);
+        EXPECT_BUDGET(UnwrapAssign, false, depth, 0, 0, valueMoves);
+        EXPECT_BUDGET(UnwrapVoid, false, depth, 0, 0, 0);
+        EXPECT_BUDGET(UnwrapDeclAct, false, depth, 0, 0, valueMoves);
+        EXPECT_BUDGET(UnwrapAssignAct, false, depth, 0, 0, valueMoves);
+        EXPECT_BUDGET(UnwrapVoidAct, false, depth, 0, 0, 0);
+        EXPECT_BUDGET(Check, false, depth, 0, 0, 0);
+        EXPECT_BUDGET(CheckAct, false, depth, 0, 0, 0);
+        EXPECT_BUDGET(CheckCtx, false, depth, 0, 0, 0);
+        EXPECT_BUDGET(Assert, false, depth, 0, 0, 0);
+        EXPECT_BUDGET(AssertTrue, false, depth, 0, 0, 0);
+        EXPECT_BUDGET(AssertFalse, false, depth, 0, 0, 0);
+        EXPECT_BUDGET(AssertNotEq, false, depth, 0, 0, 0);
+        EXPECT_BUDGET(AssertLt, false, depth, 0, 0, 0);
+        EXPECT_BUDGET(AssertRange, false, depth, 0, 0, 0);
+        EXPECT_BUDGET(AssertBytes, false, depth, 0, 0, 0);
+        EXPECT_BUDGET(CheckErrorCode, false, depth, 0, 0, 0);
+        EXPECT_BUDGET(Catch, false, depth, 0, 0, valueMoves);
+        EXPECT_BUDGET(Combinators, false, depth, 0, 0, combinatorMoves);
+
+        //The native expected allocates its error boxes on the first error of each budget: 1 when
+        //the box of the callee is freed before the one of the caller is created, 2 when both are
+        //alive at once and 3 for the combinators. The freed boxes are reused at any depth.
+        const long errorAllocations = stackAllocations + NATIVE_BOXES(2);
+        const long assertAllocations = errorAllocations + messageAllocations;
+        const long rangeAllocations = errorAllocations + rangeMessageAllocations;
+        
+        EXPECT_BUDGET(Try, true, depth, stackAllocations + NATIVE_BOXES(1), 0, 0);
+        EXPECT_BUDGET(TryAct, true, depth, errorAllocations, 0, 0);
+        EXPECT_BUDGET(CheckPrev, true, depth, stackAllocations + NATIVE_BOXES(1), 0, 0);
+        EXPECT_BUDGET(CheckPrevAct, true, depth, errorAllocations, 0, 0);
+        EXPECT_BUDGET(UnwrapDecl, true, depth, errorAllocations, 0, 0);
+        EXPECT_BUDGET(UnwrapAssign, true, depth, errorAllocations, 0, 0);
+        EXPECT_BUDGET(UnwrapVoid, true, depth, errorAllocations, 0, 0);
+        EXPECT_BUDGET(UnwrapDeclAct, true, depth, errorAllocations, 0, 0);
+        EXPECT_BUDGET(UnwrapAssignAct, true, depth, errorAllocations, 0, 0);
+        EXPECT_BUDGET(UnwrapVoidAct, true, depth, errorAllocations, 0, 0);
+        EXPECT_BUDGET(Check, true, depth, errorAllocations, 0, 0);
+        EXPECT_BUDGET(CheckAct, true, depth, errorAllocations, 0, 0);
+        EXPECT_BUDGET(CheckCtx, true, depth, contextAllocations[i] + NATIVE_BOXES(2), 0, 0);
+        EXPECT_BUDGET(Assert, true, depth, assertAllocations, 0, 0);
+        EXPECT_BUDGET(AssertTrue, true, depth, assertAllocations, 0, 0);
+        EXPECT_BUDGET(AssertFalse, true, depth, assertAllocations, 0, 0);
+        EXPECT_BUDGET(AssertNotEq, true, depth, assertAllocations, 0, 0);
+        EXPECT_BUDGET(AssertLt, true, depth, assertAllocations, 0, 0);
+        EXPECT_BUDGET(AssertRange, true, depth, rangeAllocations, 0, 0);
+        EXPECT_BUDGET(AssertBytes, true, depth, rangeAllocations, 0, 0);
+        EXPECT_BUDGET(CheckErrorCode, true, depth, errorAllocations, 0, 0);
+        EXPECT_BUDGET(Combinators, true, depth, combinatorAllocations[i] + NATIVE_BOXES(3), 0, 0);
+    }
+
+    if(FailedCount != 0)
+    {
+        std::printf("%d allocation budgets exceeded\n", FailedCount);
+        return 1;
+    }
+
+    std::printf("All allocation budgets met\n");
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include "DSResult/DSResult.hpp"
+#include "DSResult/AsyncErrorSink.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <new>
+#include <thread>
+#include <vector>
+
+//Pushes errors from several threads with each overflow policy and checks that every pushed error is
+//either written or dropped
+namespace
+{
+    const int ThreadCount = 4;
+    const int Iterations = 20000;
+
+    int FailedCount = 0;
+    std::atomic<long> WrittenCount(0);
+
+    void CountWritten(void*, const DS::ErrorTrace&)
+    {
+        ++WrittenCount;
+    }
+
+    DS::Result<int> Fail(int value)
+    {
+        if(value % 2 != 0)
+            return DS_ERROR_MSG_EC("Failed", value);
+        return value;
+    }
+
+    int Handle(DS::AsyncErrorSink& sink, int value)
+    {
+        int handled = Fail(value).DS_TRY_ACT(DS_PUSH_ERROR(sink, DS_TMP_ERROR); return -1);
+        return handled;
+    }
+
+    void Expect(const char* name, bool condition)
+    {
+        if(condition)
+            return;
+
+        ++FailedCount;
+        std::printf("FAILED %s\n", name);
+    }
+
+    void PushFromThreads(DS::AsyncErrorSink& sink)
+    {
+        std::vector<std::thread> threads;
+        for(int t = 0; t < ThreadCount; ++t)
+        {
+            threads.emplace_back([&sink]()
+            {
+                #if DS_USE_REALTIME_POOL
+                    DS::ReserveErrorPool(DS_REALTIME_DEFAULT_POOL_SIZE);
+                #endif
+
+                for(int i = 0; i < Iterations; ++i)
+                    Handle(sink, i);
+            });
+        }
+
+        for(int t = 0; t < ThreadCount; ++t)
+            threads[t].join();
+    }
+
+    //A small `capacity` makes both policies drop errors
+    void CheckPolicy(const char* name, std::size_t capacity, DS::SinkOverflowPolicy policy)
+    {
+        WrittenCount = 0;
+        DS::AsyncErrorSink sink(capacity, CountWritten, nullptr, policy);
+        PushFromThreads(sink);
+        sink.Stop();
+
+        const std::uint64_t failedCount = (std::uint64_t)ThreadCount * Iterations / 2;
+        const std::uint64_t acceptedCount = sink.GetPushedCount();
+        const std::uint64_t writtenCount = sink.GetWrittenCount();
+        const std::uint64_t droppedCount = sink.GetDroppedCount();
+        std::printf("%s: pushed %llu, written %llu, dropped %llu\n",
+                    name,
+                    (unsigned long long)acceptedCount,
+                    (unsigned long long)writtenCount,
+                    (unsigned long long)droppedCount);
+
+        Expect(name, writtenCount == (std::uint64_t)WrittenCount.load());
+        if(policy == DS::SinkOverflowPolicy::DropNewest)
+        {
+            //Dropped errors are never accepted
+            Expect(name, acceptedCount + droppedCount == failedCount);
+            Expect(name, acceptedCount == writtenCount);
+        }
+        else
+        {
+            //Every error is accepted, the oldest ones are dropped to make room
+            Expect(name, acceptedCount == failedCount);
+            Expect(name, writtenCount + droppedCount == failedCount);
+        }
+    }
+}
+
+int main()
+{
+    CheckPolicy("DropNewest", 4, DS::SinkOverflowPolicy::DropNewest);
+    CheckPolicy("DropOldest", 4, DS::SinkOverflowPolicy::DropOldest);
+    CheckPolicy("Large queue", 1 << 16, DS::SinkOverflowPolicy::DropNewest);
+
+    //`Stop()` writes the queued errors, and the destructor counts the ones pushed after it as
+    //dropped. The counters are trivially destructible, so they are read from the storage after the
+    //destructor.
+    {
+        alignas(DS::AsyncErrorSink) unsigned char storage[sizeof(DS::AsyncErrorSink)];
+        DS::AsyncErrorSink* sink = new (&storage) DS::AsyncErrorSink(64, CountWritten, nullptr);
+
+        WrittenCount = 0;
+        for(int i = 0; i < 20; ++i)
+            Handle(*sink, 1);
+        sink->Stop();
+        Expect("Stop writes the queued errors", sink->GetWrittenCount() == 20);
+        Expect("Stop writes the queued errors", WrittenCount.load() == 20);
+
+        for(int i = 0; i < 5; ++i)
+            Handle(*sink, 1);
+        Expect("Pushed after stop", sink->GetPushedCount() == 25);
+
+        sink->~AsyncErrorSink();
+        Expect("Destructor drops late pushes", sink->GetDroppedCount() == 5);
+        Expect("Destructor drops late pushes", WrittenCount.load() == 20);
+    }
+
+    if(FailedCount != 0)
+    {
+        std::printf("%d async error sink checks failed\n", FailedCount);
+        return 1;
+    }
+
+    std::printf("All async error sink checks passed\n");
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include "DSResult/DSResult.hpp"
+
+#include <cstdio>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if !DS_USE_NATIVE_EXPECTED
+    #error "NativeExpectedTest must be built with DS_USE_NATIVE_EXPECTED"
+#endif
+
+//Threads move errors out of results and modify the moved from results at the same time. The moved
+//from results share one read only empty error, which must be left untouched.
+namespace
+{
+    const int ThreadCount = 4;
+    const int Iterations = 10000;
+
+    DS::Result<int> Fail(int errorCode)
+    {
+        return DS_ERROR_MSG_EC("Failed", errorCode);
+    }
+
+    DS::Result<void> FailVoid(int errorCode)
+    {
+        return DS_ERROR_MSG_EC("Failed", errorCode);
+    }
+
+    //Returns the number of failed checks
+    int ModifyMovedFrom(int thread)
+    {
+        int failedCount = 0;
+        for(int i = 0; i < Iterations; ++i)
+        {
+            DS::Result<int> result = Fail(thread);
+            DS::Result<int> moved = std::move(result);
+            DS::Result<int> copied = result;
+            if(result.HasValue() || copied.HasValue() || moved.Error().ErrorCode != thread)
+                ++failedCount;
+
+            //Each moved from result gets its own error
+            result.Error().ErrorCode = i;
+            copied.Error().ErrorCode = -i;
+            if(result.Error().ErrorCode != i || copied.Error().ErrorCode != -i)
+                ++failedCount;
+
+            DS::Result<void> voidResult = FailVoid(thread);
+            DS::Result<void> voidMoved = std::move(voidResult);
+            voidResult.Error().ErrorCode = i;
+            if(voidResult.Error().ErrorCode != i || voidMoved.Error().ErrorCode != thread)
+                ++failedCount;
+        }
+        return failedCount;
+    }
+}
+
+int main()
+{
+    std::vector<int> failedCounts(ThreadCount, 0);
+    std::vector<std::thread> threads;
+    for(int t = 0; t < ThreadCount; ++t)
+    {
+        threads.emplace_back([&failedCounts, t]()
+        {
+            failedCounts[t] = ModifyMovedFrom(t + 1);
+        });
+    }
+
+    int failedCount = 0;
+    for(int t = 0; t < ThreadCount; ++t)
+    {
+        threads[t].join();
+        failedCount += failedCounts[t];
+    }
+
+    const DS::ErrorTrace* empty = DS::InternalNativeBox<DS::ErrorTrace>::Empty();
+    if(empty->ErrorCode != 0 || !empty->Stack.empty() || !empty->Message.empty())
+    {
+        ++failedCount;
+        std::printf("FAILED The shared empty error was modified\n");
+    }
+
+    if(failedCount != 0)
+    {
+        std::printf("%d native expected checks failed\n", failedCount);
+        return 1;
+    }
+
+    std::printf("All native expected checks passed\n");
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include "DSResult/DSResult.hpp"
+
+#include <cstdio>
+#include <string>
+
+#if DS_MAX_TRACE_DEPTH <= 0
+    #error "TraceDepthTest must be built with DS_MAX_TRACE_DEPTH"
+#endif
+
+//Appends frames from different sites to an error and checks that at most `DS_MAX_TRACE_DEPTH`
+//frames are stored, with every other frame counted as omitted
+namespace
+{
+    int FailedCount = 0;
+
+    DS::Result<int> Fail()
+    {
+        return DS_ERROR_MSG("Leaf failed");
+    }
+
+    void Expect(const char* name, int frameCount, bool condition)
+    {
+        if(condition)
+            return;
+
+        ++FailedCount;
+        std::printf("FAILED %s (%d frames, depth %d)\n", name, frameCount, DS_MAX_TRACE_DEPTH);
+    }
+
+    void CheckFrames(const char* name, const DS::ErrorTrace& trace, int frameCount, int leafLine)
+    {
+        Expect(name, frameCount, trace.Stack.size() <= (std::size_t)DS_MAX_TRACE_DEPTH);
+        Expect(name, frameCount, (int)trace.Stack.size() + trace.OmittedFrames == frameCount);
+
+        //The leaf frame is always kept
+        Expect(name, frameCount, !trace.Stack.empty() && trace.Stack.front().Line == leafLine);
+
+        if(trace.OmittedFrames > 0)
+        {
+            Expect(name, frameCount, trace.OmittedIndex <= (int)trace.Stack.size());
+            Expect( name,
+                    frameCount,
+                    trace.ToString().find(" frames omitted") != std::string::npos);
+        }
+    }
+}
+
+int main()
+{
+    const int frameCounts[] = { 1, 2, 3, DS_MAX_TRACE_DEPTH + 1, 100 };
+    for(int i = 0; i < (int)(sizeof(frameCounts) / sizeof(frameCounts[0])); ++i)
+    {
+        const int frameCount = frameCounts[i];
+        DS::Result<int> result = Fail();
+        DS::ErrorTrace& trace = result.error();
+        const int leafLine = trace.Stack.front().Line;
+
+        //Each frame has its own line so that none of them are merged
+        for(int frame = 1; frame < frameCount; ++frame)
+            trace.AppendTrace(DS::TraceElement("Level", "TraceDepthTest.cpp", 1000 + frame));
+        CheckFrames("Append", trace, frameCount, leafLine);
+
+        DS::ErrorTrace copied = trace;
+        CheckFrames("Copy", copied, frameCount, leafLine);
+
+        //The newest frame is stored whenever there's room for it after the head frames
+        if(DS_MAX_TRACE_DEPTH > 1 && frameCount > 1)
+        {
+            Expect( "Newest frame",
+                    frameCount,
+                    trace.Stack.back().Line == 1000 + frameCount - 1);
+        }
+    }
+
+    if(FailedCount != 0)
+    {
+        std::printf("%d trace depth checks failed\n", FailedCount);
+        return 1;
+    }
+
+    std::printf("All trace depth checks passed\n");
+    return 0;
+}
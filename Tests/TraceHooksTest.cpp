@@ -0,0 +1,153 @@
+#include "DSResult/DSResult.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#if !DS_USE_TRACE_HOOKS
+    #error "TraceHooksTest must be built with DS_USE_TRACE_HOOKS"
+#endif
+
+//Counts the calls of each hook and records the function of the last site
+namespace
+{
+    int FailedCount = 0;
+
+    struct CountingHooks : DS::TraceHooks
+    {
+        int CreatedCount;
+        int AppendedCount;
+        int PrevCheckedCount;
+        int ProcessedCount;
+        const char* LastCreatedFunction;
+        const char* LastProcessedFunction;
+
+        CountingHooks() :   CreatedCount(0),
+                            AppendedCount(0),
+                            PrevCheckedCount(0),
+                            ProcessedCount(0),
+                            LastCreatedFunction(""),
+                            LastProcessedFunction("")
+        {}
+
+        void OnErrorCreated(const DS::ErrorTrace&, const DS::TraceElement& site) override
+        {
+            ++CreatedCount;
+            LastCreatedFunction = site.Function;
+        }
+
+        void OnTraceAppended(const DS::ErrorTrace&, const DS::TraceElement&) override
+        {
+            ++AppendedCount;
+        }
+
+        void OnPrevChecked(const DS::ErrorTrace&, const DS::TraceElement&) override
+        {
+            ++PrevCheckedCount;
+        }
+
+        void OnErrorProcessed(const DS::ErrorTrace&, const DS::TraceElement& site) override
+        {
+            ++ProcessedCount;
+            LastProcessedFunction = site.Function;
+        }
+    };
+
+    void Expect(const char* name, bool condition)
+    {
+        if(condition)
+            return;
+
+        ++FailedCount;
+        std::printf("FAILED %s\n", name);
+    }
+
+    void ExpectCounts(  const char* name,
+                        const CountingHooks& hooks,
+                        int created,
+                        int appended,
+                        int prevChecked,
+                        int processed)
+    {
+        if( hooks.CreatedCount == created &&
+            hooks.AppendedCount == appended &&
+            hooks.PrevCheckedCount == prevChecked &&
+            hooks.ProcessedCount == processed)
+        {
+            return;
+        }
+
+        ++FailedCount;
+        std::printf("FAILED %s: created %d (expected %d), appended %d (expected %d), "
+                    "prev checked %d (expected %d), processed %d (expected %d)\n",
+                    name,
+                    hooks.CreatedCount,
+                    created,
+                    hooks.AppendedCount,
+                    appended,
+                    hooks.PrevCheckedCount,
+                    prevChecked,
+                    hooks.ProcessedCount,
+                    processed);
+    }
+}
+
+DS::Result<int> Leaf(bool fail)
+{
+    if(fail)
+        return DS_ERROR_MSG("Leaf failed");
+    return 1;
+}
+
+DS::Result<int> Unwrap(bool fail)
+{
+    DS_UNWRAP_DECL(int value, Leaf(fail));
+    return value + 1;
+}
+
+DS::Result<int> Try(bool fail)
+{
+    int value = Unwrap(fail).DS_TRY();
+    return value + 1;
+}
+
+int main()
+{
+    CountingHooks hooks;
+    DS::SetTraceHooks(&hooks);
+
+    //The success path doesn't call any hook
+    {
+        DS::Result<int> result = Try(false);
+        Expect("Success path result", result.HasValue() && result.value() == 3);
+        ExpectCounts("Success path", hooks, 0, 0, 0, 0);
+    }
+
+    //Created in `Leaf()`, appended by `DS_UNWRAP_DECL`, then `DS_TRY` processes the error with
+    //the frame of `Unwrap()` as the site, checks it as the previous error and appends its frame
+    {
+        DS::Result<int> result = Try(true);
+        Expect("Error path result", !result.HasValue());
+        ExpectCounts("Error path", hooks, 1, 2, 1, 1);
+        Expect("Created site", std::strcmp(hooks.LastCreatedFunction, "Leaf") == 0);
+        Expect("Processed site", std::strcmp(hooks.LastProcessedFunction, "Unwrap") == 0);
+        if(!result.HasValue())
+            Expect("Error path frames", result.error().Stack.size() == 3);
+    }
+
+    //Nothing is called once the hooks are unregistered
+    {
+        DS::SetTraceHooks(nullptr);
+        DS::Result<int> result = Try(true);
+        Expect("Unregistered result", !result.HasValue());
+        ExpectCounts("Unregistered", hooks, 1, 2, 1, 1);
+    }
+
+    if(FailedCount != 0)
+    {
+        std::printf("%d trace hook checks failed\n", FailedCount);
+        return 1;
+    }
+
+    std::printf("All trace hook checks passed\n");
+    return 0;
+}